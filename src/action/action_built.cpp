@@ -40,6 +40,7 @@
 #include "iolib.h"
 #include "map/map.h"
 #include "map/map_layer.h"
+#include "map/resource_index.h"
 #include "map/site.h"
 #include "map/site_game_data.h"
 #include "map/terrain_type.h"
@@ -287,7 +288,11 @@ static void Finish(COrder_Built &order, CUnit &unit)
 		if (!type.get_starting_resources().empty()) {
 			unit.SetResourcesHeld(vector::get_random(type.get_starting_resources()));
 		}
+		const int old_resource = unit.GivesResource;
 		unit.GivesResource = type.get_given_resource()->get_index();
+		if (!unit.Removed && unit.GivesResource != old_resource) {
+			unit.MapLayer->get_resource_index()->on_unit_given_resource_changed(&unit, old_resource);
+		}
 		//Wyrmgus end
 	}
 
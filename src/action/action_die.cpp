@@ -126,6 +126,7 @@ void COrder_Die::Execute(CUnit &unit)
 	//Wyrmgus start
 	const unsigned int var_size = UnitTypeVar.GetNumberVariable();
 	unit.Variable = corpse_type->Stats[unit.Player->Index].Variables;
+	unit.update_increasing_variables();
 	//Wyrmgus end
 	UpdateUnitSightRange(unit);
 	//Wyrmgus start
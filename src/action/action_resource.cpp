@@ -146,6 +146,7 @@ static bool FindNearestReachableTerrainType(const tile_flag movemask, const int
 //	terrainTraversal.SetSize(CMap::Map.Info.MapWidth, CMap::Map.Info.MapHeight);
 	terrainTraversal.SetSize(CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z]);
 	//Wyrmgus end
+	terrainTraversal.set_bounds(QRect(startPos, QSize(1, 1)), range);
 	terrainTraversal.Init();
 
 	//Wyrmgus start
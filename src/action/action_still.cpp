@@ -283,9 +283,9 @@ static bool LeaveShelter(CUnit &unit)
 	
 	std::vector<CUnit *> table;
 	if (unit.Type->BoolFlag[FAUNA_INDEX].value) {
-		SelectAroundUnit(*unit.Container, 1, table, HasNotSamePlayerAs(*unit.Player));
+		SelectAroundUnit(*unit.Container, 1, table, ~(static_cast<uint64_t>(1) << unit.Player->Index), HasNotSamePlayerAs(*unit.Player));
 	} else {
-		SelectAroundUnit(*unit.Container, unit.CurrentSightRange, table, MakeAndPredicate(IsEnemyWithPlayer(*unit.Player), HasNotSamePlayerAs(*CPlayer::Players[PlayerNumNeutral])));
+		SelectAroundUnit(*unit.Container, unit.CurrentSightRange, table, unit.Player->get_potential_enemy_owner_mask() & ~(static_cast<uint64_t>(1) << PlayerNumNeutral), MakeAndPredicate(IsEnemyWithPlayer(*unit.Player), HasNotSamePlayerAs(*CPlayer::Players[PlayerNumNeutral])));
 	}
 
 	if (table.size() > 0) {
@@ -555,7 +555,10 @@ bool AutoAttack(CUnit &unit)
 			this->AutoAttackStand(unit);
 		}
 	} else {
-		if (AutoCast(unit) || (unit.IsAgressive() && AutoAttack(unit))
+		//if no enemy was found in reaction range when thinking in this cycle, there is no need to search for one again
+		const bool may_find_enemy = this->think_cycle != GameCycle || this->enemy_in_react_range;
+
+		if (AutoCast(unit) || (unit.IsAgressive() && may_find_enemy && AutoAttack(unit))
 			|| AutoRepair(unit)
 			//Wyrmgus start
 //			|| MoveRandomly(unit)) {
@@ -564,3 +567,58 @@ bool AutoAttack(CUnit &unit)
 		}
 	}
 }
+
+/* virtual */ void COrder_Still::think(const CUnit &unit)
+{
+	//search for an enemy in reaction range for the units which would do so when executing the order
+	if (this->Action != UnitAction::Still || this->State != SUB_STILL_STANDBY || unit.Removed || !unit.CanMove()) {
+		return;
+	}
+
+	if (unit.Variable[STUN_INDEX].Value > 0 || !unit.IsAgressive()) {
+		return;
+	}
+
+	this->think_cycle = GameCycle;
+	this->enemy_in_react_range = AttackUnitsInReactRange(unit) != nullptr;
+}
+
+/* virtual */ bool COrder_Still::can_sleep(const CUnit &unit) const
+{
+	//only units which can't move, attack or cast spells on their own can sleep, as otherwise their order looks for something to do each cycle
+	if (this->State != SUB_STILL_STANDBY || unit.Removed || unit.CanMove() || unit.IsAgressive() || !unit.get_autocast_spells().empty()) {
+		return false;
+	}
+
+	if (unit.Variable[STUN_INDEX].Value != 0) {
+		return false;
+	}
+
+	//the unit must be playing its current still animation, which e.g. a change of variation can replace
+	const CAnimation *still_animation = unit.get_animation_set()->Still.get();
+	return still_animation != nullptr && unit.Anim.CurrAnim == still_animation;
+}
+
+/* virtual */ int COrder_Still::get_sleep_cycles(const CUnit &unit) const
+{
+	if (!this->can_sleep(unit)) {
+		return 0;
+	}
+
+	//the unit can sleep while its still animation waits for the next frame
+	return std::max(unit.Anim.Wait - 1, 0);
+}
+
+/* virtual */ void COrder_Still::execute_asleep(CUnit &unit)
+{
+	//do the same as Execute() does for a unit which can sleep, including drawing the idle sound's synced random number, so that the random number sequence stays the same
+	--unit.Anim.Wait;
+
+	if (SyncRand(100000) == 0) {
+		PlayUnitSound(unit, wyrmgus::unit_sound_type::idle);
+	}
+
+	unit.reset_step_count();
+
+	this->Finished = (this->Action == UnitAction::Still);
+}
@@ -199,7 +199,7 @@ int TransformUnitIntoType(CUnit &unit, const wyrmgus::unit_type &newtype)
 			unit.Variable[i].Value = unit.Variable[i].Max;
 		} else {
 			unit.Variable[i].Max += newstats.Variables[i].Max - oldstats.Variables[i].Max;
-			unit.Variable[i].Increase += newstats.Variables[i].Increase - oldstats.Variables[i].Increase;
+			unit.change_variable_increase(i, newstats.Variables[i].Increase - oldstats.Variables[i].Increase);
 			unit.Variable[i].Enable = newstats.Variables[i].Enable;
 		}
 		//Wyrmgus end
@@ -236,6 +236,7 @@ int TransformUnitIntoType(CUnit &unit, const wyrmgus::unit_type &newtype)
 	
 	unit.Type = &newtype;
 	unit.Stats = &unit.Type->Stats[player.Index];
+	unit.wake_up();
 	
 	//Wyrmgus start
 	//change the civilization/faction upgrade markers for those of the new type
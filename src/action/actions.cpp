@@ -74,6 +74,7 @@
 #include "unit/unit_ref.h"
 #include "unit/unit_type.h"
 #include "util/random.h"
+#include "util/thread_pool.h"
 
 unsigned SyncHash; /// Hash calculated to find sync failures
 
@@ -277,10 +278,17 @@ std::unique_ptr<COrder> CclParseOrder(lua_State *l, CUnit &unit)
 --  Actions
 ----------------------------------------------------------------------------*/
 
+static constexpr std::array SpellEffects = {BLOODLUST_INDEX, HASTE_INDEX, SLOW_INDEX, INVISIBLE_INDEX, UNHOLYARMOR_INDEX, POISON_INDEX, STUN_INDEX, BLEEDING_INDEX, LEADERSHIP_INDEX, BLESSING_INDEX, INSPIRE_INDEX, PRECISION_INDEX, REGENERATION_INDEX, BARKSKIN_INDEX, INFUSION_INDEX, TERROR_INDEX, WITHER_INDEX, DEHYDRATION_INDEX, HYDRATING_INDEX};
+
 static inline void IncreaseVariable(CUnit &unit, int index)
 {
 	unit.change_variable_value(index, unit.get_variable_increase(index));
 	unit.Variable[index].Value = std::clamp(unit.Variable[index].Value, 0, unit.Variable[index].Max);
+
+	//a spell effect which is active has to be counted down each cycle, so the unit can't keep sleeping
+	if (unit.get_variable_value(index) > 0 && std::find(SpellEffects.begin(), SpellEffects.end(), index) != SpellEffects.end()) {
+		unit.wake_up();
+	}
 	
 	//Wyrmgus start
 	if (index == HP_INDEX && unit.Variable[index].Increase < 0 && unit.HasInventory()) {
@@ -347,7 +355,6 @@ static void HandleBuffsEachCycle(CUnit &unit)
 		}
 	}
 	
-	static constexpr std::array SpellEffects = {BLOODLUST_INDEX, HASTE_INDEX, SLOW_INDEX, INVISIBLE_INDEX, UNHOLYARMOR_INDEX, POISON_INDEX, STUN_INDEX, BLEEDING_INDEX, LEADERSHIP_INDEX, BLESSING_INDEX, INSPIRE_INDEX, PRECISION_INDEX, REGENERATION_INDEX, BARKSKIN_INDEX, INFUSION_INDEX, TERROR_INDEX, WITHER_INDEX, DEHYDRATION_INDEX, HYDRATING_INDEX};
 	//  decrease spells effects time.
 	for (const auto spell_effect : SpellEffects) {
 		if (unit.get_variable_value(spell_effect) <= 0) {
@@ -364,6 +371,30 @@ static void HandleBuffsEachCycle(CUnit &unit)
 	}
 }
 
+/**
+**  Get whether handling the unit's buffs each cycle would do nothing
+**
+**  @param unit  the unit to check
+*/
+static bool AreBuffsIdle(const CUnit &unit)
+{
+	if (unit.TTL != 0 || unit.Threshold != 0 || !unit.get_spell_cooldown_timers().empty()) {
+		return false;
+	}
+
+	if (!unit.Type->Stats[unit.Player->Index].get_unit_stocks().empty()) {
+		return false;
+	}
+
+	for (const auto spell_effect : SpellEffects) {
+		if (unit.get_variable_value(spell_effect) > 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /**
 **  Modify unit's health according to burn and poison
 **
@@ -418,20 +449,30 @@ static void HandleBuffsEachSecond(CUnit &unit)
 	//Wyrmgus end
 	
 	// User defined variables
-	for (unsigned int i = 0; i < UnitTypeVar.GetNumberVariable(); i++) {
-		if (i == BLOODLUST_INDEX || i == HASTE_INDEX || i == SLOW_INDEX
-			|| i == INVISIBLE_INDEX || i == UNHOLYARMOR_INDEX || i == POISON_INDEX || i == STUN_INDEX || i == BLEEDING_INDEX || i == LEADERSHIP_INDEX || i == BLESSING_INDEX || i == INSPIRE_INDEX || i == PRECISION_INDEX || i == REGENERATION_INDEX || i == BARKSKIN_INDEX || i == INFUSION_INDEX || i == TERROR_INDEX || i == WITHER_INDEX || i == DEHYDRATION_INDEX || i == HYDRATING_INDEX) {
-			continue;
-		}
-		if (i == HP_INDEX && HandleBurnAndPoison(unit)) {
-			continue;
-		}
+	// HP is handled even without an increase, for burning, poison and regeneration
+	if (!HandleBurnAndPoison(unit)) {
 		//Wyrmgus start
-		if (i == HP_INDEX && unit.Variable[REGENERATION_INDEX].Value > 0) {
-			unit.Variable[i].Value += 1;
-			unit.Variable[i].Value = std::clamp(unit.Variable[i].Value, 0, unit.GetModifiedVariable(i, VariableAttribute::Max));
+		if (unit.Variable[REGENERATION_INDEX].Value > 0) {
+			unit.Variable[HP_INDEX].Value += 1;
+			unit.Variable[HP_INDEX].Value = std::clamp(unit.Variable[HP_INDEX].Value, 0, unit.GetModifiedVariable(HP_INDEX, VariableAttribute::Max));
 		}
 		//Wyrmgus end
+		if (unit.Variable[HP_INDEX].Enable && unit.Variable[HP_INDEX].Increase) {
+			IncreaseVariable(unit, HP_INDEX);
+		}
+	}
+
+	// Other variables only need to be checked if they may have an increase; the list is searched again after each variable, since increasing one can change it
+	unit.prune_increasing_variables();
+	const std::vector<int> &increasing_variables = unit.get_increasing_variables();
+
+	for (auto iterator = std::upper_bound(increasing_variables.begin(), increasing_variables.end(), HP_INDEX); iterator != increasing_variables.end(); iterator = std::upper_bound(increasing_variables.begin(), increasing_variables.end(), *iterator)) {
+		const int i = *iterator;
+
+		if (std::find(SpellEffects.begin(), SpellEffects.end(), i) != SpellEffects.end()) {
+			continue;
+		}
+
 		if (unit.Variable[i].Enable && unit.Variable[i].Increase) {
 			IncreaseVariable(unit, i);
 		}
@@ -463,6 +504,7 @@ static void HandleBuffsEachSecond(CUnit &unit)
 				std::vector<CUnit *> table;
 				SelectAroundUnit(unit, 1, table, IsEnemyWithUnit(&unit));
 				if (table.size() == 0) { //only apply the -stalk invisibility if the unit is not adjacent to an enemy unit
+					unit.wake_up();
 					unit.Variable[INVISIBLE_INDEX].Enable = 1;
 					unit.Variable[INVISIBLE_INDEX].Max = std::max(CYCLES_PER_SECOND + 1, unit.Variable[INVISIBLE_INDEX].Max);
 					unit.Variable[INVISIBLE_INDEX].Value = std::max(CYCLES_PER_SECOND + 1, unit.Variable[INVISIBLE_INDEX].Value);
@@ -480,6 +522,7 @@ static void HandleBuffsEachSecond(CUnit &unit)
 			&& unit.Variable[HYDRATING_INDEX].Value <= 0
 			&& unit.Variable[DEHYDRATIONIMMUNITY_INDEX].Value <= 0
 		) {
+			unit.wake_up();
 			unit.Variable[DEHYDRATION_INDEX].Enable = 1;
 			unit.Variable[DEHYDRATION_INDEX].Max = std::max(CYCLES_PER_SECOND + 1, unit.Variable[DEHYDRATION_INDEX].Max);
 			unit.Variable[DEHYDRATION_INDEX].Value = std::max(CYCLES_PER_SECOND + 1, unit.Variable[DEHYDRATION_INDEX].Value);
@@ -555,11 +598,28 @@ static void HandleUnitAction(CUnit &unit)
 	}
 }
 
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachSecond(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+/**
+**  Get for how many of the following cycles the unit can sleep, i.e. its buffs and its order would do nothing but count down its animation frame
+**
+**  @param unit  the unit to check
+*/
+static int GetUnitSleepCycles(const CUnit &unit)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
+	if (unit.Anim.Unbreakable || unit.CriticalOrder != nullptr || unit.Orders.size() != 1 || unit.Type->OnEachCycle) {
+		return 0;
+	}
+
+	if (!AreBuffsIdle(unit)) {
+		return 0;
+	}
+
+	return unit.Orders[0]->get_sleep_cycles(unit);
+}
+
+static void UnitActionsEachSecond(const std::vector<CUnit *> &units, const size_t unit_count)
+{
+	for (size_t i = 0; i < unit_count; ++i) {
+		CUnit &unit = *units[i];
 
 		if (unit.Destroyed) {
 			continue;
@@ -581,11 +641,10 @@ static void UnitActionsEachSecond(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 	}
 }
 
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachFiveSeconds(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+static void UnitActionsEachFiveSeconds(const std::vector<CUnit *> &units, const size_t unit_count)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
+	for (size_t i = 0; i < unit_count; ++i) {
+		CUnit &unit = *units[i];
 
 		if (unit.Destroyed) {
 			continue;
@@ -598,11 +657,58 @@ static void UnitActionsEachFiveSeconds(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 	}
 }
 
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+/**
+**  Let the orders of the units think, i.e. do the read-only part of their execution for the cycle, in parallel
+**
+**  The game state isn't changed while the orders think, so that their results don't depend on the number of threads;
+**  the orders then apply them when executed, in the order of the unit list.
+*/
+static void UnitThinkEachCycle(const std::vector<CUnit *> &units, const size_t unit_count)
+{
+	static constexpr size_t units_per_task = 64;
+
+	const size_t task_count = (unit_count + units_per_task - 1) / units_per_task;
+	std::vector<std::future<void>> futures;
+	futures.reserve(task_count);
+	std::vector<std::exception_ptr> exceptions(task_count);
+
+	for (size_t task_index = 0; task_index < task_count; ++task_index) {
+		std::future<void> future = wyrmgus::thread_pool::get()->async([&units, &exceptions, unit_count, task_index]() {
+			try {
+				const size_t end = std::min((task_index + 1) * units_per_task, unit_count);
+
+				for (size_t i = task_index * units_per_task; i < end; ++i) {
+					const CUnit &unit = *units[i];
+
+					if (unit.Destroyed || unit.Orders.empty() || unit.get_wake_cycle() > GameCycle) {
+						continue;
+					}
+
+					unit.Orders[0]->think(unit);
+				}
+			} catch (...) {
+				exceptions[task_index] = std::current_exception();
+			}
+		});
+
+		futures.push_back(std::move(future));
+	}
+
+	for (std::future<void> &future : futures) {
+		future.wait();
+	}
+
+	for (const std::exception_ptr &exception : exceptions) {
+		if (exception != nullptr) {
+			std::rethrow_exception(exception);
+		}
+	}
+}
+
+static void UnitActionsEachCycle(const std::vector<CUnit *> &units, const size_t unit_count)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
+	for (size_t i = 0; i < unit_count; ++i) {
+		CUnit &unit = *units[i];
 
 		if (unit.Destroyed) {
 			continue;
@@ -620,17 +726,34 @@ static void UnitActionsEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 			unit.Type->OnEachCycle->run();
 		}
 
-		// Handle each cycle buffs
-		HandleBuffsEachCycle(unit);
-		// Unit could be dead after TTL kill
-		if (unit.Destroyed) {
-			continue;
+		//anything which could make a sleeping unit act wakes it up explicitly, but the order's own cheap conditions are checked as well, so that e.g. a change of its still animation isn't missed
+		if (unit.get_wake_cycle() > GameCycle && !unit.Orders[0]->can_sleep(unit)) {
+			unit.wake_up();
 		}
 
-		try {
-			HandleUnitAction(unit);
-		} catch (AnimationDie_Exception &) {
-			AnimationDie_OnCatch(unit);
+		if (unit.get_wake_cycle() > GameCycle) {
+			//sleeping units are still visited in order, since their order may draw synced random numbers
+			unit.Orders[0]->execute_asleep(unit);
+		} else {
+			// Handle each cycle buffs
+			HandleBuffsEachCycle(unit);
+			// Unit could be dead after TTL kill
+			if (unit.Destroyed) {
+				continue;
+			}
+
+			try {
+				HandleUnitAction(unit);
+			} catch (AnimationDie_Exception &) {
+				AnimationDie_OnCatch(unit);
+			}
+
+			if (!unit.Destroyed) {
+				const int sleep_cycles = GetUnitSleepCycles(unit);
+				if (sleep_cycles > 0) {
+					unit.sleep_until(GameCycle + sleep_cycles + 1);
+				}
+			}
 		}
 
 		// Calculate some hash.
@@ -641,11 +764,10 @@ static void UnitActionsEachCycle(UNITP_ITERATOR begin, UNITP_ITERATOR end)
 }
 
 //Wyrmgus start
-template <typename UNITP_ITERATOR>
-static void UnitActionsEachMinute(UNITP_ITERATOR begin, UNITP_ITERATOR end)
+static void UnitActionsEachMinute(const std::vector<CUnit *> &units, const size_t unit_count)
 {
-	for (UNITP_ITERATOR it = begin; it != end; ++it) {
-		CUnit &unit = **it;
+	for (size_t i = 0; i < unit_count; ++i) {
+		CUnit &unit = *units[i];
 
 		if (unit.Destroyed) {
 			continue;
@@ -675,23 +797,27 @@ void UnitActions()
 {
 	const bool isASecondCycle = !(GameCycle % CYCLES_PER_SECOND);
 
-	//unit list may be modified during loop... so make a copy
-	std::vector<CUnit *> table = wyrmgus::unit_manager::get()->get_units();
+	//the unit list may be modified during the loop, so iterate it in place with the unit manager keeping the indices stable; units created during the loop are appended after the iterated ones, and so only act from the next cycle on
+	wyrmgus::unit_manager *unit_manager = wyrmgus::unit_manager::get();
+	const wyrmgus::unit_manager::iteration_guard iteration_guard(unit_manager);
+	const std::vector<CUnit *> &units = unit_manager->get_units();
+	const size_t unit_count = units.size();
 
 	//check for things that only happen every second
 	if (isASecondCycle) {
-		UnitActionsEachSecond(table.begin(), table.end());
+		UnitActionsEachSecond(units, unit_count);
 	}
 	
 	if ((GameCycle % (CYCLES_PER_SECOND * 5)) == 0) {
-		UnitActionsEachFiveSeconds(table.begin(), table.end());
+		UnitActionsEachFiveSeconds(units, unit_count);
 	}
 	// Do all actions
-	UnitActionsEachCycle(table.begin(), table.end());
+	UnitThinkEachCycle(units, unit_count);
+	UnitActionsEachCycle(units, unit_count);
 	
 	//Wyrmgus start
 	if ((GameCycle % CYCLES_PER_MINUTE) == 0) {
-		UnitActionsEachMinute(table.begin(), table.end());
+		UnitActionsEachMinute(units, unit_count);
 	}
 	//Wyrmgus end
 }
@@ -64,6 +64,8 @@ static void ReleaseOrders(CUnit &unit)
 {
 	Assert(unit.Orders.empty() == false);
 
+	unit.wake_up();
+
 	// Order 0 must be stopped in the action loop.
 	for (const std::unique_ptr<COrder> &order : unit.Orders) {
 		if (order->Action == UnitAction::Built) {
@@ -109,6 +111,7 @@ static std::unique_ptr<COrder> *GetNextOrder(CUnit &unit, int flush)
 	if (unit.Orders.size() == maxOrderCount) {
 		return nullptr;
 	}
+	unit.wake_up();
 	unit.Orders.push_back(nullptr);
 	return &unit.Orders.back();
 }
@@ -123,6 +126,7 @@ static void RemoveOrder(CUnit &unit, unsigned int order)
 {
 	Assert(order < unit.Orders.size());
 
+	unit.wake_up();
 	unit.Orders.erase(unit.Orders.begin() + order);
 	if (unit.Orders.empty()) {
 		unit.Orders.push_back(COrder::NewActionStill());
@@ -1053,6 +1057,7 @@ void CommandTrainUnit(CUnit &unit, const wyrmgus::unit_type &type, int player, i
 		Assert(unit.CriticalOrder == nullptr);
 		
 		unit.CriticalOrder = COrder::NewActionTrain(unit, type, player);
+		unit.wake_up();
 		return;
 	}
 	//Wyrmgus end
@@ -1164,6 +1169,7 @@ void CommandTransformIntoType(CUnit &unit, wyrmgus::unit_type &type)
 	Assert(unit.CriticalOrder == nullptr);
 
 	unit.CriticalOrder = COrder::NewActionTransformInto(type);
+	unit.wake_up();
 }
 
 /**
@@ -1411,14 +1417,14 @@ void CommandSharedVision(int player, bool state, int opponent)
 				wyrmgus::tile &mf = *CMap::Map.Field(i, z);
 				const std::unique_ptr<wyrmgus::tile_player_info> &mfp = mf.player_info;
 
-				if (mfp->Visible[player] && !mfp->Visible[opponent] && !CPlayer::Players[player]->is_revealed()) {
-					mfp->Visible[opponent] = 1;
+				if (mfp->get_visibility(player) && !mfp->get_visibility(opponent) && !CPlayer::Players[player]->is_revealed()) {
+					mfp->set_visibility(opponent, 1);
 					if (opponent == CPlayer::GetThisPlayer()->Index) {
 						CMap::Map.MarkSeenTile(mf);
 					}
 				}
-				if (mfp->Visible[opponent] && !mfp->Visible[player] && !CPlayer::Players[opponent]->is_revealed()) {
-					mfp->Visible[player] = 1;
+				if (mfp->get_visibility(opponent) && !mfp->get_visibility(player) && !CPlayer::Players[opponent]->is_revealed()) {
+					mfp->set_visibility(player, 1);
 					if (player == CPlayer::GetThisPlayer()->Index) {
 						CMap::Map.MarkSeenTile(mf);
 					}
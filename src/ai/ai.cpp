@@ -132,6 +132,7 @@
 #include "action/action_attack.h"
 #include "civilization.h"
 #include "commands.h"
+#include "cycle_profiler.h"
 #include "database/defines.h"
 //Wyrmgus start
 #include "editor.h"
@@ -1509,10 +1510,10 @@ void AiEachSecond(CPlayer &player)
 	AiCheckUnits();
 
 	//  Handle the resource manager.
-	AiResourceManager();
+	cycle_profiler::profile(cycle_profiler_stage::ai_resource_manager, AiResourceManager);
 
 	//  Handle the force manager.
-	AiForceManager();
+	cycle_profiler::profile(cycle_profiler_stage::ai_force_manager, AiForceManager);
 
 	//  Check for magic actions.
 	AiCheckMagic();
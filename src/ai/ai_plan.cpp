@@ -177,6 +177,8 @@ static bool FindWall(const CUnit &unit, int range, Vec2i *wallPos)
 	TerrainTraversal terrainTraversal;
 
 	terrainTraversal.SetSize(unit.MapLayer->get_width(), unit.MapLayer->get_height());
+	//the start tiles include those adjacent to the unit
+	terrainTraversal.set_bounds(unit.get_tile_rect(), range + 1);
 	terrainTraversal.Init();
 
 	terrainTraversal.PushUnitPosAndNeighbor(unit);
@@ -244,7 +244,7 @@ int AiEnemyUnitsInDistance(const CPlayer &player,
 	if (type == nullptr) {
 		//Wyrmgus start
 //		Select(pos - offset, pos + offset, units, IsAEnemyUnitOf(player));
-		Select(pos - offset, pos + offset, units, z, IsAEnemyUnitOf(player));
+		Select(pos - offset, pos + offset, units, z, player.get_potential_enemy_owner_mask(), IsAEnemyUnitOf(player));
 		//Wyrmgus end
 		return static_cast<int>(units.size());
 	} else {
@@ -253,7 +253,7 @@ int AiEnemyUnitsInDistance(const CPlayer &player,
 
 		//Wyrmgus start
 //		Select(pos - offset, pos + typeSize + offset, units, pred);
-		Select(pos - offset, pos + typeSize + offset, units, z, pred);
+		Select(pos - offset, pos + typeSize + offset, units, z, player.get_potential_enemy_owner_mask(), pred);
 		//Wyrmgus end
 		return static_cast<int>(units.size());
 	}
@@ -347,18 +347,19 @@ static int AiBuildBuilding(const wyrmgus::unit_type &type, const wyrmgus::unit_t
 	
 	CUnit *near_unit = nullptr;
 	if (building.TerrainType || building.BoolFlag[TOWNHALL_INDEX].value) { //terrain type units and town halls have a particular place to be built, so we need to find the worker with a terrain traversal
+		int maxRange = 15;
+		if (building.BoolFlag[TOWNHALL_INDEX].value) { //for settlements, look farther for builders
+			maxRange = 9999;
+		}
+
 		TerrainTraversal terrainTraversal;
 
 		terrainTraversal.SetSize(CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z]);
+		terrainTraversal.set_bounds(QRect(nearPos, QSize(1, 1)), maxRange);
 		terrainTraversal.Init();
 
 		terrainTraversal.PushPos(nearPos);
 
-		int maxRange = 15;
-		if (building.BoolFlag[TOWNHALL_INDEX].value) { //for settlements, look farther for builders
-			maxRange = 9999;
-		}
-
 		tile_flag movemask = type.MovementMask & ~(tile_flag::land_unit | tile_flag::air_unit | tile_flag::sea_unit);
 		if (OnTopDetails(building, nullptr)) { //if the building is built on top of something else, make sure the building it is built on top of doesn't block the movemask
 			movemask &= ~(tile_flag::building);
@@ -1974,14 +1975,17 @@ static bool AiRepairBuilding(const CPlayer &player, const wyrmgus::unit_type &ty
 	if (table.empty()) {
 		return false;
 	}
+	const int maxRange = 15;
+
 	TerrainTraversal terrainTraversal;
 
 	terrainTraversal.SetSize(building.MapLayer->get_width(), building.MapLayer->get_height());
+	//the start tiles include those adjacent to the building
+	terrainTraversal.set_bounds(building.get_tile_rect(), maxRange + 1);
 	terrainTraversal.Init();
 
 	terrainTraversal.PushUnitPosAndNeighbor(building);
 
-	const int maxRange = 15;
 	const tile_flag movemask = type.MovementMask & ~(tile_flag::land_unit | tile_flag::air_unit | tile_flag::sea_unit);
 	CUnit *unit = nullptr;
 	UnitFinder unitFinder(player, table, maxRange, movemask, &unit, building.MapLayer->ID);
@@ -74,6 +74,8 @@ void CAnimation_SetVar::Action(CUnit &unit, int &/*move*/, int /*scale*/) const
 		goal->Variable[index].Value = value;
 	}
 
+	goal->wake_up();
+
 	//Wyrmgus start
 //	goal->Variable[index].Value = std::clamp(goal->Variable[index].Value, 0, goal->Variable[index].Max);
 	goal->Variable[index].Value = std::clamp(goal->Variable[index].Value, 0, goal->GetModifiedVariable(index, VariableAttribute::Max));
@@ -40,6 +40,7 @@
 //Wyrmgus end
 #include "civilization.h"
 #include "commands.h"
+#include "cycle_profiler.h"
 #include "database/database.h"
 #include "database/defines.h"
 #include "database/sml_data.h"
@@ -223,21 +224,8 @@ void game::save(CFile &file) const
 {
 	sml_data game_data;
 
-	if (!this->player_delayed_effects.empty()) {
-		sml_data delayed_effects_data("player_delayed_effects");
-		for (const auto &delayed_effect : this->player_delayed_effects) {
-			delayed_effects_data.add_child(delayed_effect->to_sml_data());
-		}
-		game_data.add_child(std::move(delayed_effects_data));
-	}
-
-	if (!this->unit_delayed_effects.empty()) {
-		sml_data delayed_effects_data("unit_delayed_effects");
-		for (const auto &delayed_effect : this->unit_delayed_effects) {
-			delayed_effects_data.add_child(delayed_effect->to_sml_data());
-		}
-		game_data.add_child(std::move(delayed_effects_data));
-	}
+	this->save_delayed_effects(this->player_delayed_effects, "player_delayed_effects", game_data);
+	this->save_delayed_effects(this->unit_delayed_effects, "unit_delayed_effects", game_data);
 
 	sml_data site_game_data("site_data");
 	for (const site *site : site::get_all()) {
@@ -284,12 +272,27 @@ void game::process_delayed_effects()
 
 void game::add_delayed_effect(std::unique_ptr<delayed_effect_instance<CPlayer>> &&delayed_effect)
 {
-	this->player_delayed_effects.push_back(std::move(delayed_effect));
+	this->add_delayed_effect(this->player_delayed_effects, std::move(delayed_effect));
 }
 
 void game::add_delayed_effect(std::unique_ptr<delayed_effect_instance<CUnit>> &&delayed_effect)
 {
-	this->unit_delayed_effects.push_back(std::move(delayed_effect));
+	this->add_delayed_effect(this->unit_delayed_effects, std::move(delayed_effect));
+}
+
+template <typename scope_type>
+void game::save_delayed_effects(const timer_wheel<std::unique_ptr<delayed_effect_instance<scope_type>>> &delayed_effects, const std::string &tag, sml_data &game_data) const
+{
+	if (delayed_effects.empty()) {
+		return;
+	}
+
+	sml_data delayed_effects_data(tag);
+	const uint64_t current_cycle = delayed_effects.get_current_cycle();
+	delayed_effects.for_each([&delayed_effects_data, current_cycle](const uint64_t cycle, const std::unique_ptr<delayed_effect_instance<scope_type>> &delayed_effect) {
+		delayed_effects_data.add_child(delayed_effect->to_sml_data(static_cast<int>(cycle - current_cycle)));
+	});
+	game_data.add_child(std::move(delayed_effects_data));
 }
 
 void game::clear_delayed_effects()
@@ -385,13 +388,20 @@ void StartMap(const std::string &filename, bool clean)
 		}
 		UI.SelectedViewport->Center(CMap::Map.tile_pos_to_scaled_map_pixel_pos_center(CPlayer::GetThisPlayer()->StartPos));
 
-		UI.get_minimap()->Update();
+		//headless runs have no video, so they have no minimap and nothing to clear
+		const bool headless = parameters::get()->is_headless();
+
+		if (!headless) {
+			UI.get_minimap()->Update();
+		}
 
 		//  Play the game.
 		GameMainLoop();
 
 		//  Clear screen
-		Video.ClearScreen();
+		if (!headless) {
+			Video.ClearScreen();
+		}
 
 		CleanGame();
 		current_interface_state = interface_state::menu;
@@ -1795,7 +1805,9 @@ void CreateGame(const std::string &filename, CMap *map, bool is_mod)
 	UI.Load();
 
 	CMap::Map.Init();
-	UI.get_minimap()->Create();
+	if (!parameters::get()->is_headless()) {
+		UI.get_minimap()->Create();
+	}
 
 	try {
 		PreprocessMap();
@@ -1861,7 +1873,9 @@ void CreateGame(const std::string &filename, CMap *map, bool is_mod)
 	GameResult = GameNoResult;
 
 	CommandLog(nullptr, NoUnitP, FlushCommands, -1, -1, NoUnitP, nullptr, -1);
-	Video.ClearScreen();
+	if (!parameters::get()->is_headless()) {
+		Video.ClearScreen();
+	}
 	
 	//Wyrmgus start
 	ResetItemsToLoad();
@@ -1994,6 +2008,73 @@ static int CclGetGodMode(lua_State *l)
 	return 1;
 }
 
+/**
+**  Enable or disable the timing of the game cycle stages.
+**
+**  @param l  Lua state.
+*/
+static int CclSetCycleProfilerEnabled(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	cycle_profiler::get()->set_enabled(LuaToBoolean(l, 1));
+	return 0;
+}
+
+/**
+**  Get the timings of the game cycle stages over the most recent samples.
+**
+**  @param l  Lua state.
+**
+**  @return   A table with the sample count, and the total and maximum duration in microseconds, for each stage.
+*/
+static int CclGetCycleProfile(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+
+	const auto stage_stats = cycle_profiler::get()->get_stage_stats();
+
+	lua_newtable(l);
+
+	for (size_t i = 0; i < stage_stats.size(); ++i) {
+		const cycle_profiler::stage_stats &stats = stage_stats[i];
+
+		lua_pushstring(l, get_cycle_profiler_stage_name(static_cast<cycle_profiler_stage>(i)));
+		lua_newtable(l);
+
+		lua_pushstring(l, "Count");
+		lua_pushnumber(l, static_cast<lua_Number>(stats.count));
+		lua_rawset(l, -3);
+		lua_pushstring(l, "TotalMicroseconds");
+		lua_pushnumber(l, static_cast<lua_Number>(stats.total_duration));
+		lua_rawset(l, -3);
+		lua_pushstring(l, "MaxMicroseconds");
+		lua_pushnumber(l, static_cast<lua_Number>(stats.max_duration));
+		lua_rawset(l, -3);
+
+		lua_rawset(l, -3);
+	}
+
+	return 1;
+}
+
+/**
+**  Save the timings of the game cycle stages to a file, as Chrome trace JSON if it has the ".json" extension, or as CSV otherwise.
+**
+**  @param l  Lua state.
+*/
+static int CclSaveCycleProfile(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+
+	try {
+		cycle_profiler::get()->save(LuaToString(l, 1));
+	} catch (const std::exception &exception) {
+		LuaError(l, "%s" _C_ exception.what());
+	}
+
+	return 0;
+}
+
 /**
 **  Set resource harvesting speed (deprecated).
 **
@@ -2327,6 +2408,10 @@ void LuaRegisterModules()
 	lua_register(Lua, "SetGodMode", CclSetGodMode);
 	lua_register(Lua, "GetGodMode", CclGetGodMode);
 
+	lua_register(Lua, "SetCycleProfilerEnabled", CclSetCycleProfilerEnabled);
+	lua_register(Lua, "GetCycleProfile", CclGetCycleProfile);
+	lua_register(Lua, "SaveCycleProfile", CclSaveCycleProfile);
+
 	lua_register(Lua, "SetSpeedResourcesHarvest", CclSetSpeedResourcesHarvest);
 	lua_register(Lua, "SetSpeedResourcesReturn", CclSetSpeedResourcesReturn);
 	lua_register(Lua, "SetSpeedBuild", CclSetSpeedBuild);
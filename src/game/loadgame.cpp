@@ -44,6 +44,7 @@
 #include "map/site_game_data.h"
 #include "map/terrain_type.h"
 #include "missile.h"
+#include "parameters.h"
 #include "particle.h"
 #include "pathfinder.h"
 #include "quest/quest.h"
@@ -219,7 +220,9 @@ void LoadModules()
 	}
 
 	SetPlayersPalette();
-	UI.get_minimap()->Create();
+	if (!parameters::get()->is_headless()) {
+		UI.get_minimap()->Create();
+	}
 
 	//Wyrmgus start
 	ResetItemsToLoad();
@@ -729,6 +729,14 @@ int LoadReplay(const std::string &name)
 
 	LuaLoadFile(name);
 
+	//the simulation may differ between protocol versions, e.g. in when idle units react to enemies, so replays recorded with another one may not play back as they were recorded
+	if (CurrentReplay != nullptr) {
+		const int replay_protocol_version = CurrentReplay->Network[0] * 10000 + CurrentReplay->Network[1] * 100 + CurrentReplay->Network[2];
+		if (replay_protocol_version != NetworkProtocolVersion) {
+			fprintf(stderr, "Replay \"%s\" was recorded with network protocol version " NetworkProtocolFormatString ", but the current one is " NetworkProtocolFormatString ", so it may go out of sync.\n", name.c_str(), NetworkProtocolFormatArgs(replay_protocol_version), NetworkProtocolFormatArgs(NetworkProtocolVersion));
+		}
+	}
+
 	NextLogCycle = ~0UL;
 	if (!CommandLogDisabled) {
 		CommandLogDisabled = true;
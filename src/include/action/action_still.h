@@ -49,9 +49,16 @@ public:
 	virtual void OnAnimationAttack(CUnit &unit);
 	virtual PixelPos Show(const CViewport &vp, const PixelPos &lastScreenPos) const;
 	virtual void UpdatePathFinderData(PathFinderInput &input) { UpdatePathFinderData_NotCalled(input); }
+
+	virtual void think(const CUnit &unit) override;
+	virtual bool can_sleep(const CUnit &unit) const override;
+	virtual int get_sleep_cycles(const CUnit &unit) const override;
+	virtual void execute_asleep(CUnit &unit) override;
 private:
 	bool AutoAttackStand(CUnit &unit);
 	bool AutoCastStand(CUnit &unit);
 private:
 	int State;
+	unsigned long think_cycle = 0; /// the game cycle in which the order last thought
+	bool enemy_in_react_range = false; /// whether an enemy was found in reaction range when the order last thought
 };
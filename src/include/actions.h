@@ -135,6 +135,34 @@ public:
 
 	virtual void UpdatePathFinderData(PathFinderInput &input) = 0;
 
+	//do the read-only part of the order's execution for the current cycle ahead of it, storing the results in the order; this is done for all units in parallel, while the game state isn't changed
+	virtual void think(const CUnit &unit)
+	{
+		Q_UNUSED(unit)
+	}
+
+	//get whether the order's own conditions for the unit to sleep hold, which must be cheap to check, as this is done each cycle while the unit is asleep
+	virtual bool can_sleep(const CUnit &unit) const
+	{
+		Q_UNUSED(unit)
+
+		return false;
+	}
+
+	//get for how many of the following cycles executing the order would do nothing but count down the unit's current animation frame, so that the unit can sleep during them
+	virtual int get_sleep_cycles(const CUnit &unit) const
+	{
+		Q_UNUSED(unit)
+
+		return 0;
+	}
+
+	//do what executing the order does while the unit is asleep
+	virtual void execute_asleep(CUnit &unit)
+	{
+		Q_UNUSED(unit)
+	}
+
 	bool has_goal() const
 	{
 		return this->goal != nullptr;
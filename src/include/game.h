@@ -27,6 +27,7 @@
 #pragma once
 
 #include "util/singleton.h"
+#include "util/timer_wheel.h"
 
 class CFile;
 class CPlayer;
@@ -106,21 +107,29 @@ public:
 
 private:
 	template <typename scope_type>
-	void process_delayed_effects(std::vector<std::unique_ptr<delayed_effect_instance<scope_type>>> &delayed_effects)
+	void process_delayed_effects(timer_wheel<std::unique_ptr<delayed_effect_instance<scope_type>>> &delayed_effects)
 	{
-		for (size_t i = 0; i < delayed_effects.size();) {
-			const std::unique_ptr<delayed_effect_instance<scope_type>> &delayed_effect = delayed_effects[i];
-			delayed_effect->decrement_remaining_cycles();
-
-			if (delayed_effect->get_remaining_cycles() <= 0) {
-				delayed_effect->do_effects();
-				delayed_effects.erase(delayed_effects.begin() + i);
-			} else {
-				++i;
-			}
+		delayed_effects.advance(delayed_effects.get_current_cycle() + 1, [](const std::unique_ptr<delayed_effect_instance<scope_type>> &delayed_effect) {
+			delayed_effect->do_effects();
+		});
+	}
+
+	template <typename scope_type>
+	void add_delayed_effect(timer_wheel<std::unique_ptr<delayed_effect_instance<scope_type>>> &delayed_effects, std::unique_ptr<delayed_effect_instance<scope_type>> &&delayed_effect)
+	{
+		//the wheel's cycles are its processing passes rather than game cycles, and a delayed effect is due in the pass which counts its remaining cycles down to zero
+		//that is the pass being processed if the effect is added during it (e.g. by another delayed effect), and otherwise the next one
+		uint64_t cycle = delayed_effects.get_current_cycle() + std::max(delayed_effect->get_remaining_cycles(), 1);
+		if (delayed_effects.is_advancing()) {
+			--cycle;
 		}
+
+		delayed_effects.insert(cycle, std::move(delayed_effect));
 	}
 
+	template <typename scope_type>
+	void save_delayed_effects(const timer_wheel<std::unique_ptr<delayed_effect_instance<scope_type>>> &delayed_effects, const std::string &tag, sml_data &game_data) const;
+
 public:
 	void add_delayed_effect(std::unique_ptr<delayed_effect_instance<CPlayer>> &&delayed_effect);
 	void add_delayed_effect(std::unique_ptr<delayed_effect_instance<CUnit>> &&delayed_effect);
@@ -132,8 +141,8 @@ private:
 	QDateTime current_date;
 	uint64_t current_total_hours = 0; //the total in-game hours
 	std::vector<std::unique_ptr<trigger>> local_triggers; //triggers "local" to the current game
-	std::vector<std::unique_ptr<delayed_effect_instance<CPlayer>>> player_delayed_effects;
-	std::vector<std::unique_ptr<delayed_effect_instance<CUnit>>> unit_delayed_effects;
+	timer_wheel<std::unique_ptr<delayed_effect_instance<CPlayer>>> player_delayed_effects; //delayed effects keyed by the processing pass in which they are due
+	timer_wheel<std::unique_ptr<delayed_effect_instance<CUnit>>> unit_delayed_effects;
 };
 
 }
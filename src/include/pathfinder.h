@@ -41,6 +41,7 @@ class CFile;
 struct lua_State;
 
 namespace wyrmgus {
+	class flow_field;
 	enum class tile_flag : uint32_t;
 }
 
@@ -123,6 +124,7 @@ class PathFinderData final
 public:
 	PathFinderInput input;
 	PathFinderOutput output;
+	std::shared_ptr<wyrmgus::flow_field> flow_field; /// flow field shared with other units moving to the same goal
 };
 
 //  Terrain traversal stuff.
@@ -134,12 +136,22 @@ enum class VisitResult {
 	Cancel
 };
 
+//the values of the traversal are kept in buffers which are reused by later traversals, with each traversal using a new generation, and a value being unvisited if its stamp is not equal to the traversal's generation
+//this way a traversal doesn't need to clear a map-sized buffer before running
 class TerrainTraversal
 {
 public:
 	using dataType = short int;
 
+	TerrainTraversal() = default;
+	~TerrainTraversal();
+
+	TerrainTraversal(const TerrainTraversal &other) = delete;
+	TerrainTraversal &operator =(const TerrainTraversal &other) = delete;
+
 	void SetSize(unsigned int width, unsigned int height);
+	//restrict the traversal to the tiles within a radius of a rectangle, for searches whose range is known; tiles outside that window are treated as if they were outside the map
+	void set_bounds(const QRect &rect, const int radius);
 	void SetDiagonalAllowed(bool allowed);
 	void Init();
 
@@ -172,11 +184,23 @@ private:
 		Vec2i from;
 	};
 
+	struct buffer final
+	{
+		std::vector<dataType> values;
+		std::vector<uint32_t> stamps;
+		uint32_t generation = 0;
+	};
+
+	//the buffers not in use by any traversal of the current thread
+	static std::vector<std::unique_ptr<buffer>> &get_free_buffers();
+
 private:
-	std::vector<dataType> m_values;
+	std::unique_ptr<buffer> m_buffer;
 	std::queue<PosNode> m_queue;
-	unsigned int m_extented_width;
-	unsigned int m_height;
+	int m_min_x = 0; /// the top-left corner of the traversal's window
+	int m_min_y = 0;
+	unsigned int m_width = 0; /// the size of the traversal's window
+	unsigned int m_height = 0;
 	bool allow_diagonal = true;
 };
 
@@ -216,6 +240,8 @@ constexpr std::array<int, 9> Heading2Y = { -1, -1, 0, +1, +1, +1, 0, -1, 0 };
 extern void InitPathfinder();
 /// Free the pathfinder
 extern void FreePathfinder();
+/// Notify the pathfinder of a change to a tile's passability or movement cost
+extern void PathfinderTileChanged(const Vec2i &pos, int z);
 
 /// Returns the next element of the path
 extern int NextPathElement(CUnit &unit, int &xdp, int &ydp);
@@ -252,4 +278,25 @@ extern int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, in
 						 //Wyrmgus end
 //Wyrmgus end
 
+/// A request for an a* path, which can be solved together with other requests
+class AStarPathRequest final
+{
+public:
+	Vec2i StartPos = Vec2i(0, 0);
+	Vec2i GoalPos = Vec2i(0, 0);
+	Vec2i GoalSize = Vec2i(0, 0);
+	Vec2i UnitSize = Vec2i(1, 1);
+	int MinRange = 0;
+	int MaxRange = 0;
+	std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *Path = nullptr;
+	const CUnit *Unit = nullptr;
+	int MaxLength = 0;
+	int MapLayer = 0;
+	bool AllowDiagonal = true;
+	int Result = PF_FAILED; /// the result of AStarFindPath for the request
+};
+
+/// Find a* paths for several independent requests in parallel
+extern void AStarFindPaths(std::vector<AStarPathRequest> &requests);
+
 extern void PathfinderCclRegister();
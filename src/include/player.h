@@ -96,9 +96,18 @@ public:
 		return CPlayer::revealed_players;
 	}
 
+	//get the revealed players as a mask, with each player being represented as one bit
+	static uint64_t get_revealed_player_mask()
+	{
+		return CPlayer::revealed_player_mask;
+	}
+
+	static void update_mutual_shared_vision_masks();
+
 private:
 	static CPlayer *ThisPlayer; //player on local computer
 	static inline std::vector<const CPlayer *> revealed_players;
+	static inline uint64_t revealed_player_mask = 0;
 
 public:
 	CPlayer();
@@ -860,6 +869,9 @@ public:
 	bool IsEnemy(const CPlayer &player) const;
 	bool IsEnemy(const CUnit &unit) const;
 
+	//get the players whose units may be enemies of this player or of its units, with each player being represented as one bit
+	uint64_t get_potential_enemy_owner_mask() const;
+
 	bool IsAllied(const int index) const
 	{
 		return this->Index != index && this->allies.contains(index);
@@ -883,6 +895,12 @@ public:
 	bool has_shared_vision_with(const CUnit &unit) const;
 	bool has_mutual_shared_vision_with(const CPlayer &player) const;
 	bool has_mutual_shared_vision_with(const CUnit &unit) const;
+
+	//get the mask of the players whose vision this player sees, i.e. the player itself and the players with which it has mutual shared vision
+	uint64_t get_team_vision_mask() const
+	{
+		return this->mutual_shared_vision_mask | (static_cast<uint64_t>(1) << this->Index);
+	}
 	bool IsTeamed(const CPlayer &player) const;
 	bool IsTeamed(const CUnit &unit) const;
 
@@ -1008,6 +1026,7 @@ private:
 	wyrmgus::player_index_set enemies; //enemies for this player
 	wyrmgus::player_index_set allies; //allies for this player
 	wyrmgus::player_index_set shared_vision; //set of player indexes that this player has shared vision with
+	uint64_t mutual_shared_vision_mask = 0; //mask of the players with which this player has mutual shared vision
 
 	friend void CleanPlayers();
 	friend void SetPlayersPalette();
@@ -190,6 +190,7 @@ extern void Exit(int err);                  /// Exit
 extern void UpdateDisplay();            /// Game display update
 extern void DrawMapArea();              /// Draw the map area
 extern void GameMainLoop();             /// Game main loop
+extern int HeadlessExitCode;            /// Exit code of a headless run
 extern void stratagusMain(int argc, char **argv); /// main entry
 
 //Wyrmgus start
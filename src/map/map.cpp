@@ -42,6 +42,7 @@
 #include "map/map_template.h"
 #include "map/minimap.h"
 #include "map/plane.h"
+#include "map/resource_index.h"
 #include "map/site.h"
 #include "map/site_container.h"
 #include "map/site_game_data.h"
@@ -52,6 +53,7 @@
 #include "map/tileset.h"
 #include "map/world.h"
 #include "map/world_game_data.h"
+#include "pathfinder.h"
 #include "player.h"
 //Wyrmgus start
 #include "province.h"
@@ -214,7 +216,7 @@ void CMap::Reveal(bool only_person_players)
 			const std::unique_ptr<wyrmgus::tile_player_info> &player_info = mf.player_info;
 			for (int p = 0; p < PlayerMax; ++p) {
 				if (CPlayer::Players[p]->Type == PlayerPerson || !only_person_players) {
-					player_info->Visible[p] = std::max<unsigned short>(1, player_info->Visible[p]);
+					player_info->set_visibility(p, std::max<unsigned short>(1, player_info->get_visibility(p)));
 				}
 			}
 			MarkSeenTile(mf);
@@ -1920,6 +1922,11 @@ void CMap::save(CFile &file) const
 	file.printf("  },\n");
 	//Wyrmgus end
 
+	//the tiles' values are only updated for destroyed overlay terrain when it decays, so bring them up to date
+	for (const std::unique_ptr<CMapLayer> &map_layer : this->MapLayers) {
+		map_layer->update_destroyed_overlay_terrain_tile_values();
+	}
+
 	file.printf("  \"map-fields\", {\n");
 	//Wyrmgus start
 	/*
@@ -2105,6 +2112,8 @@ void CMap::SetTileTerrain(const Vec2i &pos, const wyrmgus::terrain_type *terrain
 	}
 	
 	mf.SetTerrain(terrain);
+	PathfinderTileChanged(pos, z);
+	this->MapLayers[z]->get_resource_index()->on_tile_changed(pos);
 	
 	if (terrain->is_overlay()) {
 		//remove decorations if the overlay terrain has changed
@@ -2167,6 +2176,8 @@ void CMap::RemoveTileOverlayTerrain(const Vec2i &pos, int z)
 	}
 	
 	mf.RemoveOverlayTerrain();
+	PathfinderTileChanged(pos, z);
+	this->MapLayers[z]->get_resource_index()->on_tile_changed(pos);
 	
 	this->CalculateTileTransitions(pos, true, z);
 	
@@ -2211,6 +2222,8 @@ void CMap::SetOverlayTerrainDestroyed(const Vec2i &pos, bool destroyed, int z)
 	mf.SetOverlayTerrainDestroyed(destroyed);
 	
 	if (destroyed) {
+		mf.set_value(0);
+
 		if (mf.get_overlay_terrain()->has_flag(tile_flag::tree)) {
 			mf.Flags &= ~(tile_flag::tree | tile_flag::impassable);
 			mf.Flags |= tile_flag::stumps;
@@ -2227,10 +2240,8 @@ void CMap::SetOverlayTerrainDestroyed(const Vec2i &pos, bool destroyed, int z)
 				}
 			}
 
-			map_layer->destroyed_overlay_terrain_tiles.push_back(pos);
+			map_layer->add_destroyed_overlay_terrain_tile(pos);
 		}
-
-		mf.set_value(0);
 	} else {
 		if (mf.has_flag(tile_flag::stumps)) { //if is a cleared tree tile regrowing trees
 			mf.Flags &= ~(tile_flag::stumps);
@@ -2238,6 +2249,9 @@ void CMap::SetOverlayTerrainDestroyed(const Vec2i &pos, bool destroyed, int z)
 			mf.set_value(mf.get_overlay_terrain()->get_resource()->get_default_amount());
 		}
 	}
+
+	PathfinderTileChanged(pos, z);
+	map_layer->get_resource_index()->on_tile_changed(pos);
 	
 	if (destroyed) {
 		if (mf.get_overlay_terrain()->get_destroyed_tiles().size() > 0) {
@@ -389,6 +389,8 @@ extern std::string CurrentMapPath; /// Path to the current map
 
 /// Contrast of fog of war
 extern int FogOfWarOpacity;
+/// Whether to compare the sight obstacle results with those of CheckObstaclesBetweenTiles
+extern bool ValidateSightObstacles;
 /// fog of war color
 extern CColor FogOfWarColor;
 /// Flag must reveal the map
@@ -456,6 +458,16 @@ extern template void MapSight<MapUnmarkTileRadar>(const CPlayer &player, const V
 extern template void MapSight<MapMarkTileRadarJammer>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
 extern template void MapSight<MapUnmarkTileRadarJammer>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
 
+/// Move the sight, updating only the tiles which leave or enter it
+template <wyrmgus::map_marker_func_ptr unmarker, wyrmgus::map_marker_func_ptr marker>
+extern void MapSightMove(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+
+extern template void MapSightMove<MapUnmarkTileSight, MapMarkTileSight>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+extern template void MapSightMove<MapUnmarkTileDetectCloak, MapMarkTileDetectCloak>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+extern template void MapSightMove<MapUnmarkTileDetectEthereal, MapMarkTileDetectEthereal>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+extern template void MapSightMove<MapUnmarkTileRadar, MapMarkTileRadar>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+extern template void MapSightMove<MapUnmarkTileRadarJammer, MapMarkTileRadarJammer>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+
 /// Update fog of war
 extern void UpdateFogOfWarChange();
 
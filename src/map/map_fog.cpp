@@ -43,12 +43,14 @@
 #include "unit/unit_find.h"
 //Wyrmgus end
 #include "unit/unit_manager.h"
+#include "util/circle_util.h"
 #include "util/util.h"
 #include "video/intern_video.h"
 #include "video/video.h"
 
 
 int FogOfWarOpacity;                 /// Fog of war Opacity.
+bool ValidateSightObstacles = false; /// Compare the sight obstacle results with those of CheckObstaclesBetweenTiles
 uint32_t FogOfWarColorSDL;
 CColor FogOfWarColor;
 
@@ -252,7 +254,7 @@ void MapMarkTileSight(const CPlayer &player, const unsigned int index, int z)
 //	wyrmgus::tile &mf = *CMap::Map.Field(index);
 	wyrmgus::tile &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned short &v = mf.player_info->Visible[player.Index];
+	const unsigned short v = mf.player_info->get_visibility(player.Index);
 	if (v == 0 || v == 1) { // Unexplored or unseen
 		// When there is no fog only unexplored tiles are marked.
 		if (!CMap::Map.NoFogOfWar || v == 0) {
@@ -261,14 +263,14 @@ void MapMarkTileSight(const CPlayer &player, const unsigned int index, int z)
 			UnitsOnTileMarkSeen(player, mf, 0, 0);
 			//Wyrmgus end
 		}
-		v = 2;
+		mf.player_info->set_visibility(player.Index, 2);
 		if (mf.player_info->IsTeamVisible(*CPlayer::GetThisPlayer())) {
 			CMap::Map.MarkSeenTile(mf);
 		}
 		return;
 	}
 	Assert(v != 65535);
-	++v;
+	mf.player_info->set_visibility(player.Index, v + 1);
 }
 
 //Wyrmgus start
@@ -295,7 +297,7 @@ void MapUnmarkTileSight(const CPlayer &player, const unsigned int index, int z)
 //	wyrmgus::tile &mf = *CMap::Map.Field(index);
 	wyrmgus::tile &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned short &v = mf.player_info->Visible[player.Index];
+	const unsigned short v = mf.player_info->get_visibility(player.Index);
 	switch (v) {
 		case 0:  // Unexplored
 		case 1:
@@ -314,7 +316,7 @@ void MapUnmarkTileSight(const CPlayer &player, const unsigned int index, int z)
 				CMap::Map.MarkSeenTile(mf);
 			}
 		default:  // seen -> seen
-			--v;
+			mf.player_info->set_visibility(player.Index, v - 1);
 			break;
 	}
 }
@@ -343,7 +345,7 @@ void MapMarkTileDetectCloak(const CPlayer &player, const unsigned int index, int
 //	wyrmgus::tile &mf = *CMap::Map.Field(index);
 	wyrmgus::tile &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned char &v = mf.player_info->VisCloak[player.Index];
+	unsigned char &v = mf.player_info->get_cloak_visibility_counter(player.Index);
 	if (v == 0) {
 		//Wyrmgus start
 //		UnitsOnTileMarkSeen(player, mf, 1);
@@ -380,7 +382,7 @@ void MapUnmarkTileDetectCloak(const CPlayer &player, const unsigned int index, i
 //	wyrmgus::tile &mf = *CMap::Map.Field(index);
 	wyrmgus::tile &mf = *CMap::Map.Field(index, z);
 	//Wyrmgus end
-	unsigned char &v = mf.player_info->VisCloak[player.Index];
+	unsigned char &v = mf.player_info->get_cloak_visibility_counter(player.Index);
 	Assert(v != 0);
 	if (v == 1) {
 		//Wyrmgus start
@@ -412,7 +414,7 @@ void MapUnmarkTileDetectCloak(const CPlayer &player, const Vec2i &pos, int z)
 void MapMarkTileDetectEthereal(const CPlayer &player, const unsigned int index, int z)
 {
 	wyrmgus::tile &mf = *CMap::Map.Field(index, z);
-	unsigned char &v = mf.player_info->VisEthereal[player.Index];
+	unsigned char &v = mf.player_info->get_ethereal_visibility_counter(player.Index);
 	if (v == 0) {
 		UnitsOnTileMarkSeen(player, mf, 0, 1);
 	}
@@ -434,7 +436,7 @@ void MapMarkTileDetectEthereal(const CPlayer &player, const Vec2i &pos, int z)
 void MapUnmarkTileDetectEthereal(const CPlayer &player, const unsigned int index, int z)
 {
 	wyrmgus::tile &mf = *CMap::Map.Field(index, z);
-	unsigned char &v = mf.player_info->VisEthereal[player.Index];
+	unsigned char &v = mf.player_info->get_ethereal_visibility_counter(player.Index);
 	Assert(v != 0);
 	if (v == 1) {
 		UnitsOnTileUnmarkSeen(player, mf, 0, 1);
@@ -448,35 +450,188 @@ void MapUnmarkTileDetectEthereal(const CPlayer &player, const Vec2i &pos, int z)
 }
 //Wyrmgus end
 
+static constexpr tile_flag sight_obstacle_flag = tile_flag::air_impassable;
+static constexpr int max_sight_obstacle_difference = 1; //how many tiles are seen after the obstacle; set to 1 here so that the obstacle tiles themselves don't have fog drawn over them
+
 /**
-**  Mark the sight of unit. (Explore and make visible.)
+**  For each offset from a viewing tile, the offsets of the tiles whose sight line is blocked by an obstacle at that offset.
 **
-**  @param player  player to mark the sight for (not unit owner)
-**  @param pos     location to mark
-**  @param w       width to mark, in square
-**  @param h       height to mark, in square
-**  @param range   Radius to mark.
-**  @param marker  Function to mark or unmark sight
+**  The sight lines are the same Bresenham lines as those of CheckObstaclesBetweenTiles, and the blocked offsets are sorted by their distance.
 */
-template <wyrmgus::map_marker_func_ptr marker>
-//Wyrmgus start
-//void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range)
-void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range, int z)
-//Wyrmgus end
+static std::vector<std::vector<Vec2i>> SightShadowTable;
+static int SightShadowTableRange = -1;
+
+static int GetSightShadowTableIndex(const Vec2i &offset)
+{
+	const int width = SightShadowTableRange * 2 + 1;
+	return (offset.y + SightShadowTableRange) * width + offset.x + SightShadowTableRange;
+}
+
+/**
+**  Build the sight shadow table for offsets up to a given range.
+**
+**  @param range  Maximum distance of the offsets in the table.
+*/
+static void BuildSightShadowTable(const int range)
+{
+	SightShadowTableRange = range;
+	SightShadowTable.clear();
+	SightShadowTable.resize(square(range * 2 + 1));
+
+	std::vector<Vec2i> goal_offsets;
+	for (int y = -range; y <= range; ++y) {
+		for (int x = -range; x <= range; ++x) {
+			goal_offsets.push_back(Vec2i(x, y));
+		}
+	}
+
+	//sort by distance, so that lookups can stop at the range they need
+	std::stable_sort(goal_offsets.begin(), goal_offsets.end(), [](const Vec2i &lhs, const Vec2i &rhs) {
+		return std::max(abs(lhs.x), abs(lhs.y)) < std::max(abs(rhs.x), abs(rhs.y));
+	});
+
+	for (const Vec2i &goal_offset : goal_offsets) {
+		//trace the line in the same way as CheckObstaclesBetweenTiles
+		const Vec2i delta(abs(goal_offset.x), abs(goal_offset.y));
+		const Vec2i sign(0 < goal_offset.x ? 1 : -1, 0 < goal_offset.y ? 1 : -1);
+		int error = delta.x - delta.y;
+		Vec2i offset(0, 0);
+
+		while (offset != goal_offset) {
+			const int error2 = error * 2;
+
+			if (error2 > -delta.y) {
+				error -= delta.y;
+				offset.x += sign.x;
+			}
+			if (error2 < delta.x) {
+				error += delta.x;
+				offset.y += sign.y;
+			}
+
+			if (abs(offset.x - goal_offset.x) > max_sight_obstacle_difference || abs(offset.y - goal_offset.y) > max_sight_obstacle_difference) {
+				SightShadowTable[GetSightShadowTableIndex(offset)].push_back(goal_offset);
+			}
+		}
+	}
+}
+
+/**
+**  Calculate which tiles in a sight rectangle are visible from any tile of a unit, i.e. which have no obstacles between them and at least one of the unit's tiles.
+**
+**  This gives the same results as calling CheckObstaclesBetweenTiles for each pair of tiles, but instead of tracing each line, the tiles shadowed by each obstacle are marked through the shadow table.
+**
+**  @param pos             Top left tile of the unit.
+**  @param w               Width of the unit.
+**  @param h               Height of the unit.
+**  @param z               Map layer.
+**  @param sight_rect      The rectangle of tiles to check.
+**  @param visible_tiles   Set to whether each tile of the rectangle is visible.
+*/
+static void CalculateSightVisibility(const Vec2i &pos, const int w, const int h, const int z, const QRect &sight_rect, std::vector<bool> &visible_tiles)
 {
+	const int table_range = std::max({ pos.x - sight_rect.left(), sight_rect.right() - pos.x, pos.y - sight_rect.top(), sight_rect.bottom() - pos.y }) + std::max(w, h);
+	if (table_range > SightShadowTableRange) {
+		BuildSightShadowTable(table_range);
+	}
+
+	const int rect_width = sight_rect.width();
+	const int rect_area = rect_width * sight_rect.height();
+	visible_tiles.assign(rect_area, false);
+
+	std::vector<Vec2i> obstacle_positions;
+	for (int y = sight_rect.top(); y <= sight_rect.bottom(); ++y) {
+		for (int x = sight_rect.left(); x <= sight_rect.right(); ++x) {
+			if (CMap::Map.Field(x, y, z)->has_flag(sight_obstacle_flag)) {
+				obstacle_positions.push_back(Vec2i(x, y));
+			}
+		}
+	}
+
+	std::vector<bool> blocked_tiles;
+
+	for (int x = 0; x < w; ++x) {
+		for (int y = 0; y < h; ++y) {
+			const Vec2i origin = pos + Vec2i(x, y);
+
+			blocked_tiles.assign(rect_area, false);
+
+			for (const Vec2i &obstacle_pos : obstacle_positions) {
+				for (const Vec2i &goal_offset : SightShadowTable[GetSightShadowTableIndex(obstacle_pos - origin)]) {
+					const QPoint goal_pos = origin + goal_offset;
+
+					if (!sight_rect.contains(goal_pos)) {
+						if (std::max(abs(goal_offset.x), abs(goal_offset.y)) > table_range) {
+							break;
+						}
+						continue;
+					}
+
+					blocked_tiles[(goal_pos.y() - sight_rect.top()) * rect_width + goal_pos.x() - sight_rect.left()] = true;
+				}
+			}
+
+			//the obstacle must be avoidable from at least one of the unit's tiles
+			for (int i = 0; i < rect_area; ++i) {
+				if (!blocked_tiles[i]) {
+					visible_tiles[i] = true;
+				}
+			}
+		}
+	}
+
+	if (ValidateSightObstacles) {
+		for (int i = 0; i < rect_area; ++i) {
+			const Vec2i goal_pos(sight_rect.left() + i % rect_width, sight_rect.top() + i / rect_width);
+
+			bool visible = false;
+			for (int x = 0; x < w && !visible; ++x) {
+				for (int y = 0; y < h; ++y) {
+					if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), goal_pos, sight_obstacle_flag, z, max_sight_obstacle_difference)) {
+						visible = true;
+						break;
+					}
+				}
+			}
+
+			if (visible != visible_tiles[i]) {
+				fprintf(stderr, "Sight obstacle mismatch for the tile (%d, %d) seen from (%d, %d) with size (%d, %d) on map layer %d: the shadow table gives %d, while CheckObstaclesBetweenTiles gives %d.\n", goal_pos.x, goal_pos.y, pos.x, pos.y, w, h, z, static_cast<int>(visible_tiles[i]), static_cast<int>(visible));
+				visible_tiles[i] = visible;
+			}
+		}
+	}
+}
+
+/**
+**  Get the tiles in the sight of a unit, in ascending order of their indexes.
+**
+**  @param pos           location of the sight
+**  @param w             width of the sight's origin, in square
+**  @param h             height of the sight's origin, in square
+**  @param range         Radius of the sight.
+**  @param z             Map layer.
+**  @param tile_indexes  Set to the indexes of the tiles in sight.
+*/
+static void GetSightTiles(const Vec2i &pos, const int w, const int h, const int range, const int z, std::vector<unsigned int> &tile_indexes)
+{
+	tile_indexes.clear();
+
 	// Units under construction have no sight range.
 	if (!range) {
 		return;
 	}
 
-	static constexpr tile_flag sight_obstacle_flag = tile_flag::air_impassable;
-	static constexpr int max_obstacle_difference = 1; //how many tiles are seen after the obstacle; set to 1 here so that the obstacle tiles themselves don't have fog drawn over them
+	const QRect sight_rect = QRect(QPoint(pos.x - range, pos.y - range), QPoint(pos.x + w - 1 + range, pos.y + h - 1 + range)).intersected(QRect(QPoint(0, 0), QSize(CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z])));
+	std::vector<bool> visible_tiles;
+	CalculateSightVisibility(pos, w, h, z, sight_rect, visible_tiles);
+
+	const std::vector<int> &row_half_widths = wyrmgus::circle::get_row_half_widths(wyrmgus::circle::get_range_squared_radius(range));
 	
 	// Up hemi-cyle
 	const int miny = std::max(-range, 0 - pos.y);
 	
 	for (int offsety = miny; offsety != 0; ++offsety) {
-		const int offsetx = isqrt(square(range + 1) - square(-offsety) - 1);
+		const int offsetx = wyrmgus::circle::get_row_half_width(row_half_widths, offsety);
 		const int minx = std::max(0, pos.x - offsetx);
 		//Wyrmgus start
 //		const int maxx = std::min(CMap::Map.Info.MapWidth, pos.x + w + offsetx);
@@ -489,26 +644,11 @@ void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range,
 		//Wyrmgus end
 
 		for (mpos.x = minx; mpos.x < maxx; ++mpos.x) {
-			bool obstacle_check = false;
-			for (int x = 0; x < w; ++x) {
-				for (int y = 0; y < h; ++y) {
-					if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, sight_obstacle_flag, z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
-						obstacle_check = true;
-						break;
-					}
-				}
-				if (obstacle_check) {
-					break;
-				}
-			}
-			if (!obstacle_check) {
+			if (!visible_tiles[(mpos.y - sight_rect.top()) * sight_rect.width() + mpos.x - sight_rect.left()]) {
 				continue;
 			}
 
-			//Wyrmgus start
-//			marker(player, mpos.x + index);
-			marker(player, mpos.x + index, z);
-			//Wyrmgus end
+			tile_indexes.push_back(mpos.x + index);
 		}
 	}
 	for (int offsety = 0; offsety < h; ++offsety) {
@@ -524,26 +664,11 @@ void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range,
 		//Wyrmgus end
 
 		for (mpos.x = minx; mpos.x < maxx; ++mpos.x) {
-			bool obstacle_check = false;
-			for (int x = 0; x < w; ++x) {
-				for (int y = 0; y < h; ++y) {
-					if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, sight_obstacle_flag, z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
-						obstacle_check = true;
-						break;
-					}
-				}
-				if (obstacle_check) {
-					break;
-				}
-			}
-			if (!obstacle_check) {
+			if (!visible_tiles[(mpos.y - sight_rect.top()) * sight_rect.width() + mpos.x - sight_rect.left()]) {
 				continue;
 			}
 
-			//Wyrmgus start
-//			marker(player, mpos.x + index);
-			marker(player, mpos.x + index, z);
-			//Wyrmgus end
+			tile_indexes.push_back(mpos.x + index);
 		}
 	}
 	// bottom hemi-cycle
@@ -552,7 +677,7 @@ void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range,
 	const int maxy = std::min(range, CMap::Map.Info.MapHeights[z] - pos.y - h);
 	//Wyrmgus end
 	for (int offsety = 0; offsety < maxy; ++offsety) {
-		const int offsetx = isqrt(square(range + 1) - square(offsety + 1) - 1);
+		const int offsetx = wyrmgus::circle::get_row_half_width(row_half_widths, offsety + 1);
 		const int minx = std::max(0, pos.x - offsetx);
 		//Wyrmgus start
 //		const int maxx = std::min(CMap::Map.Info.MapWidth, pos.x + w + offsetx);
@@ -565,30 +690,39 @@ void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range,
 		//Wyrmgus end
 
 		for (mpos.x = minx; mpos.x < maxx; ++mpos.x) {
-			bool obstacle_check = false;
-			for (int x = 0; x < w; ++x) {
-				for (int y = 0; y < h; ++y) {
-					if (CheckObstaclesBetweenTiles(pos + Vec2i(x, y), mpos, sight_obstacle_flag, z, max_obstacle_difference)) { //the obstacle must be avoidable from at least one of the unit's tiles
-						obstacle_check = true;
-						break;
-					}
-				}
-				if (obstacle_check) {
-					break;
-				}
-			}
-			if (!obstacle_check) {
+			if (!visible_tiles[(mpos.y - sight_rect.top()) * sight_rect.width() + mpos.x - sight_rect.left()]) {
 				continue;
 			}
 
-			//Wyrmgus start
-//			marker(player, mpos.x + index);
-			marker(player, mpos.x + index, z);
-			//Wyrmgus end
+			tile_indexes.push_back(mpos.x + index);
 		}
 	}
 }
 
+/**
+**  Mark the sight of unit. (Explore and make visible.)
+**
+**  @param player  player to mark the sight for (not unit owner)
+**  @param pos     location to mark
+**  @param w       width to mark, in square
+**  @param h       height to mark, in square
+**  @param range   Radius to mark.
+**  @param marker  Function to mark or unmark sight
+*/
+template <wyrmgus::map_marker_func_ptr marker>
+//Wyrmgus start
+//void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range)
+void MapSight(const CPlayer &player, const Vec2i &pos, int w, int h, int range, int z)
+//Wyrmgus end
+{
+	std::vector<unsigned int> tile_indexes;
+	GetSightTiles(pos, w, h, range, z, tile_indexes);
+
+	for (const unsigned int tile_index : tile_indexes) {
+		marker(player, tile_index, z);
+	}
+}
+
 template void MapSight<MapMarkTileSight>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
 template void MapSight<MapUnmarkTileSight>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
 template void MapSight<MapMarkTileDetectCloak>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
@@ -600,6 +734,49 @@ template void MapSight<MapUnmarkTileRadar>(const CPlayer &player, const Vec2i &p
 template void MapSight<MapMarkTileRadarJammer>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
 template void MapSight<MapUnmarkTileRadarJammer>(const CPlayer &player, const Vec2i &pos, const int w, const int h, const int range, const int z);
 
+/**
+**  Move the sight of a unit to a new location, updating only the tiles which leave or enter the sight.
+**
+**  The result is the same as unmarking the sight at the old location and marking it at the new one, but the tiles which stay in sight are not touched.
+**
+**  @param player    player to move the sight for (not unit owner)
+**  @param old_pos   old location of the sight
+**  @param new_pos   new location of the sight
+**  @param w         width of the sight's origin, in square
+**  @param h         height of the sight's origin, in square
+**  @param range     Radius of the sight.
+**  @param z         Map layer.
+**  @param unmarker  Function to unmark the tiles leaving the sight
+**  @param marker    Function to mark the tiles entering the sight
+*/
+template <wyrmgus::map_marker_func_ptr unmarker, wyrmgus::map_marker_func_ptr marker>
+void MapSightMove(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z)
+{
+	std::vector<unsigned int> old_tile_indexes;
+	GetSightTiles(old_pos, w, h, range, z, old_tile_indexes);
+
+	std::vector<unsigned int> new_tile_indexes;
+	GetSightTiles(new_pos, w, h, range, z, new_tile_indexes);
+
+	for (const unsigned int tile_index : old_tile_indexes) {
+		if (!std::binary_search(new_tile_indexes.begin(), new_tile_indexes.end(), tile_index)) {
+			unmarker(player, tile_index, z);
+		}
+	}
+
+	for (const unsigned int tile_index : new_tile_indexes) {
+		if (!std::binary_search(old_tile_indexes.begin(), old_tile_indexes.end(), tile_index)) {
+			marker(player, tile_index, z);
+		}
+	}
+}
+
+template void MapSightMove<MapUnmarkTileSight, MapMarkTileSight>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+template void MapSightMove<MapUnmarkTileDetectCloak, MapMarkTileDetectCloak>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+template void MapSightMove<MapUnmarkTileDetectEthereal, MapMarkTileDetectEthereal>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+template void MapSightMove<MapUnmarkTileRadar, MapMarkTileRadar>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+template void MapSightMove<MapUnmarkTileRadarJammer, MapMarkTileRadarJammer>(const CPlayer &player, const Vec2i &old_pos, const Vec2i &new_pos, const int w, const int h, const int range, const int z);
+
 /**
 **  Update fog of war.
 */
@@ -31,6 +31,7 @@
 #include "database/defines.h"
 #include "map/map.h"
 #include "map/minimap.h"
+#include "map/resource_index.h"
 #include "map/terrain_type.h"
 #include "map/tile.h"
 #include "map/tile_flag.h"
@@ -44,6 +45,7 @@
 #include "time/time_of_day_schedule.h"
 #include "ui/ui.h"
 #include "unit/unit.h"
+#include "unit/unit_grid.h"
 #include "unit/unit_manager.h"
 #include "util/point_util.h"
 
@@ -64,6 +66,15 @@ CMapLayer::CMapLayer(const QSize &size) : size(size)
 	} catch (const std::bad_alloc &) {
 		std::throw_with_nested(std::runtime_error("Failed to allocate map layer with a tile area of " + std::to_string(max_tile_index) + ", for " + std::to_string(max_tile_index * sizeof(wyrmgus::tile)) + " bytes in total."));
 	}
+
+	this->visibility_planes = std::make_unique<wyrmgus::visibility_planes>(max_tile_index);
+
+	for (int i = 0; i < max_tile_index; ++i) {
+		this->Fields[i].player_info->set_visibility_planes(this->visibility_planes.get(), i);
+	}
+
+	this->unit_grid = std::make_unique<wyrmgus::unit_grid>(size);
+	this->resource_index = std::make_unique<wyrmgus::resource_index>(this);
 }
 
 CMapLayer::~CMapLayer()
@@ -121,24 +132,30 @@ void CMapLayer::DoPerHourLoop()
 	this->DecrementRemainingTimeOfDayHours();
 }
 
+void CMapLayer::add_destroyed_overlay_terrain_tile(const QPoint &pos)
+{
+	//the tile's value decreases by one each time destroyed overlay terrain is handled, until it reaches the decay threshold, so we can tell in advance when the tile will decay
+	const int decay_count = std::max(this->Field(pos)->get_value() - wyrmgus::defines::get()->get_destroyed_overlay_terrain_decay_threshold(), 1);
+
+	this->destroyed_overlay_terrain_tiles.insert(this->destroyed_overlay_terrain_tiles.get_current_cycle() + decay_count, QPoint(pos));
+}
+
 void CMapLayer::handle_destroyed_overlay_terrain()
 {
 	if (wyrmgus::defines::get()->get_destroyed_overlay_terrain_decay_threshold() == 0) {
 		return;
 	}
 
-	for (size_t i = 0; i < this->destroyed_overlay_terrain_tiles.size();) {
-		const QPoint &pos = this->destroyed_overlay_terrain_tiles[i];
-		wyrmgus::tile &mf = *this->Field(pos);
+	this->destroyed_overlay_terrain_tiles.advance(this->destroyed_overlay_terrain_tiles.get_current_cycle() + 1, [this](const QPoint &pos) {
+		const wyrmgus::tile &mf = *this->Field(pos);
 
 		if (mf.get_overlay_terrain() == nullptr || !mf.OverlayTerrainDestroyed || mf.has_flag(tile_flag::stumps)) {
-			//the destroyed overlay terrain tile may have become invalid, e.g. because the terrain changed, or because of the handling of destroyed overlay tiles itself; we keep the removal of elements centralized here so that we can loop through the tiles reliably
-			this->destroyed_overlay_terrain_tiles.erase(this->destroyed_overlay_terrain_tiles.begin() + i);
-		} else {
-			this->decay_destroyed_overlay_terrain_tile(pos);
-			++i;
+			//the destroyed overlay terrain tile may have become invalid in the meantime, e.g. because the terrain changed
+			return;
 		}
-	}
+
+		this->decay_destroyed_overlay_terrain_tile(pos);
+	});
 }
 
 void CMapLayer::decay_destroyed_overlay_terrain_tile(const QPoint &pos)
@@ -149,14 +166,30 @@ void CMapLayer::decay_destroyed_overlay_terrain_tile(const QPoint &pos)
 
 	wyrmgus::tile &mf = *this->Field(pos);
 
-	mf.decrement_value();
+	mf.set_value(wyrmgus::defines::get()->get_destroyed_overlay_terrain_decay_threshold());
+	CMap::get()->RemoveTileOverlayTerrain(pos, this->ID);
+}
 
-	if (mf.get_value() > wyrmgus::defines::get()->get_destroyed_overlay_terrain_decay_threshold()) {
+void CMapLayer::update_destroyed_overlay_terrain_tile_values()
+{
+	const int decay_threshold = wyrmgus::defines::get()->get_destroyed_overlay_terrain_decay_threshold();
+
+	if (decay_threshold == 0) {
 		return;
 	}
 
-	mf.set_value(wyrmgus::defines::get()->get_destroyed_overlay_terrain_decay_threshold());
-	CMap::get()->RemoveTileOverlayTerrain(pos, this->ID);
+	//the values of destroyed overlay terrain tiles are only updated when they decay, so set them from the time remaining until then, e.g. for saving
+	const uint64_t current_count = this->destroyed_overlay_terrain_tiles.get_current_cycle();
+
+	this->destroyed_overlay_terrain_tiles.for_each([this, decay_threshold, current_count](const uint64_t decay_count, const QPoint &pos) {
+		wyrmgus::tile &mf = *this->Field(pos);
+
+		if (mf.get_overlay_terrain() == nullptr || !mf.OverlayTerrainDestroyed || mf.has_flag(tile_flag::stumps)) {
+			return;
+		}
+
+		mf.set_value(static_cast<short>(decay_threshold + static_cast<int>(decay_count - current_count)));
+	});
 }
 
 void CMapLayer::regenerate_forests()
@@ -27,6 +27,7 @@
 #pragma once
 
 #include "map/map_template_container.h"
+#include "util/timer_wheel.h"
 #include "vec2i.h"
 
 class CUnit;
@@ -36,6 +37,7 @@ static int CclStratagusMap(lua_State *l);
 
 namespace wyrmgus {
 	class plane;
+	class resource_index;
 	class scheduled_season;
 	class scheduled_time_of_day;
 	class season;
@@ -43,6 +45,8 @@ namespace wyrmgus {
 	class tile;
 	class time_of_day;
 	class time_of_day_schedule;
+	class unit_grid;
+	class visibility_planes;
 	class world;
 }
 
@@ -113,11 +117,23 @@ public:
 	{
 		return this->get_size().height();
 	}
+
+	wyrmgus::unit_grid *get_unit_grid() const
+	{
+		return this->unit_grid.get();
+	}
+
+	wyrmgus::resource_index *get_resource_index() const
+	{
+		return this->resource_index.get();
+	}
 	
 	void DoPerCycleLoop();
 	void DoPerHourLoop();
+	void add_destroyed_overlay_terrain_tile(const QPoint &pos);
 	void handle_destroyed_overlay_terrain();
 	void decay_destroyed_overlay_terrain_tile(const QPoint &pos);
+	void update_destroyed_overlay_terrain_tile_values();
 	void regenerate_forests();
 	void regenerate_tree_tile(const QPoint &pos);
 
@@ -196,6 +212,9 @@ public:
 	int ID = -1;
 private:
 	std::unique_ptr<wyrmgus::tile[]> Fields; //fields on the map layer
+	std::unique_ptr<wyrmgus::visibility_planes> visibility_planes; //the per-player visibility of the fields
+	std::unique_ptr<wyrmgus::unit_grid> unit_grid; //the units on the map layer, in buckets of tiles
+	std::unique_ptr<wyrmgus::resource_index> resource_index; //the resource tiles and units of the map layer
 	QSize size;									/// the size in tiles of the map layer
 	const scheduled_time_of_day *time_of_day = nullptr;	/// the time of day for the map layer
 	const wyrmgus::time_of_day_schedule *time_of_day_schedule = nullptr; //the time of day schedule for the map layer
@@ -210,7 +229,7 @@ public:
 	const wyrmgus::world *world = nullptr;			/// the world pointer (if any) for the map layer
 	std::vector<CUnit *> LayerConnectors;		/// connectors in the map layer which lead to other map layers
 	wyrmgus::map_template_map<QRect> subtemplate_areas;
-	std::vector<QPoint> destroyed_overlay_terrain_tiles; /// destroyed overlay terrain tiles (excluding trees)
+	wyrmgus::timer_wheel<QPoint> destroyed_overlay_terrain_tiles; /// destroyed overlay terrain tiles (excluding trees), keyed by the number of times destroyed overlay terrain must have been handled for them to decay
 	std::vector<QPoint> destroyed_tree_tiles;	/// destroyed tree tiles; this list is used for forest regeneration
 
 	friend int CclStratagusMap(lua_State *l);
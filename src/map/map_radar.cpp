@@ -38,14 +38,12 @@
 
 static inline unsigned char IsTileRadarVisible(const CPlayer &pradar, const CPlayer &punit, const wyrmgus::tile_player_info &mfp)
 {
-	if (mfp.RadarJammer[punit.Index]) {
+	if (mfp.get_radar_jammer(punit.Index)) {
 		return 0;
 	}
 
 	const int p = pradar.Index;
 	if (pradar.IsVisionSharing()) {
-		const std::array<unsigned char, PlayerMax> &radar = mfp.Radar;
-		const std::array<unsigned char, PlayerMax> &jamming = mfp.RadarJammer;
 		unsigned char radarvision = 0;
 
 		// Check jamming first, if we are jammed, exit
@@ -54,7 +52,7 @@ static inline unsigned char IsTileRadarVisible(const CPlayer &pradar, const CPla
 				continue;
 			}
 
-			if (jamming[i] > 0) {
+			if (mfp.get_radar_jammer(i) > 0) {
 				if (CPlayer::Players[i]->has_shared_vision_with(punit.Index)) { //if the shared vision is mutual
 					// We are jammed, return nothing
 					return 0;
@@ -67,17 +65,18 @@ static inline unsigned char IsTileRadarVisible(const CPlayer &pradar, const CPla
 				continue;
 			}
 
-			if (radar[i] > 0) {
+			const unsigned char radar = mfp.get_radar(i);
+			if (radar > 0) {
 				if (CPlayer::Players[i]->has_shared_vision_with(p)) { //if the shared vision is mutual
-					radarvision |= radar[i];
+					radarvision |= radar;
 				}
 			}
 		}
 
 		// Can't exit until the end, as we might be jammed
-		return (radarvision | mfp.Radar[p]);
+		return (radarvision | mfp.get_radar(p));
 	}
-	return mfp.Radar[p];
+	return mfp.get_radar(p);
 }
 
 bool CUnit::IsVisibleOnRadar(const CPlayer &pradar) const
@@ -112,8 +111,9 @@ bool CUnit::IsVisibleOnRadar(const CPlayer &pradar) const
 */
 void MapMarkTileRadar(const CPlayer &player, const unsigned int index, int z)
 {
-	Assert(CMap::Map.Field(index, z)->player_info->Radar[player.Index] != 255);
-	CMap::Map.Field(index, z)->player_info->Radar[player.Index]++;
+	unsigned char &v = CMap::Map.Field(index, z)->player_info->get_radar_counter(player.Index);
+	Assert(v != 255);
+	v++;
 }
 
 void MapMarkTileRadar(const CPlayer &player, int x, int y, int z)
@@ -135,7 +135,7 @@ void MapUnmarkTileRadar(const CPlayer &player, const unsigned int index, int z)
 	// Reduce radar coverage if it exists.
 	//Wyrmgus start
 //	unsigned char *v = &(CMap::Map.Field(index)->player_info->Radar[player.Index]);
-	unsigned char *v = &(CMap::Map.Field(index, z)->player_info->Radar[player.Index]);
+	unsigned char *v = &(CMap::Map.Field(index, z)->player_info->get_radar_counter(player.Index));
 	//Wyrmgus end
 	if (*v) {
 		--*v;
@@ -164,8 +164,9 @@ void MapMarkTileRadarJammer(const CPlayer &player, const unsigned int index, int
 	//Wyrmgus start
 //	Assert(CMap::Map.Field(index)->player_info->RadarJammer[player.Index] != 255);
 //	CMap::Map.Field(index)->player_info->RadarJammer[player.Index]++;
-	Assert(CMap::Map.Field(index, z)->player_info->RadarJammer[player.Index] != 255);
-	CMap::Map.Field(index, z)->player_info->RadarJammer[player.Index]++;
+	unsigned char &v = CMap::Map.Field(index, z)->player_info->get_radar_jammer_counter(player.Index);
+	Assert(v != 255);
+	v++;
 	//Wyrmgus end
 }
 
@@ -190,7 +191,7 @@ void MapUnmarkTileRadarJammer(const CPlayer &player, const unsigned int index, i
 	// Reduce radar coverage if it exists.
 	//Wyrmgus start
 //	unsigned char *v = &(CMap::Map.Field(index)->player_info->RadarJammer[player.Index]);
-	unsigned char *v = &(CMap::Map.Field(index, z)->player_info->RadarJammer[player.Index]);
+	unsigned char *v = &(CMap::Map.Field(index, z)->player_info->get_radar_jammer_counter(player.Index));
 	//Wyrmgus end
 	if (*v) {
 		--*v;
@@ -320,6 +320,10 @@ void minimap::UpdateXY(const Vec2i &pos, const int z)
 
 void minimap::update_territory_xy(const QPoint &pos, const int z)
 {
+	if (z >= static_cast<int>(this->terrain_texture_data.size())) {
+		return;
+	}
+
 	const int texture_width = this->get_texture_width(z);
 	const int texture_height = this->get_texture_height(z);
 
@@ -859,6 +863,10 @@ void minimap::AddEvent(const Vec2i &pos, int z, IntColor color)
 	if (NumMinimapEvents == MAX_MINIMAP_EVENTS) {
 		return;
 	}
+	if (z >= static_cast<int>(this->terrain_texture_data.size())) {
+		//the minimap hasn't been created, e.g. in a headless run
+		return;
+	}
 	if (z == UI.CurrentMapLayer->ID) {
 		MinimapEvents[NumMinimapEvents].pos = this->tile_to_texture_pos(pos);
 		MinimapEvents[NumMinimapEvents].Size = (W < H) ? W / 3 : H / 3;
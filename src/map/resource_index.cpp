@@ -0,0 +1,190 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#include "stratagus.h"
+
+#include "map/resource_index.h"
+
+#include "map/map_layer.h"
+#include "map/tile.h"
+#include "unit/unit.h"
+
+namespace wyrmgus {
+
+resource_index::resource_index(const CMapLayer *map_layer) : map_layer(map_layer)
+{
+	this->map_size = map_layer->get_size();
+	this->bucket_grid_size = QSize((this->map_size.width() + resource_index::bucket_size - 1) / resource_index::bucket_size, (this->map_size.height() + resource_index::bucket_size - 1) / resource_index::bucket_size);
+}
+
+void resource_index::insert_unit(CUnit *unit)
+{
+	if (unit->GivesResource == 0) {
+		return;
+	}
+
+	if (unit->GivesResource >= static_cast<int>(this->resource_units.size())) {
+		this->resource_units.resize(unit->GivesResource + 1);
+	}
+
+	this->resource_units[unit->GivesResource].push_back(unit);
+}
+
+void resource_index::remove_unit(CUnit *unit)
+{
+	if (unit->GivesResource < static_cast<int>(this->resource_units.size())) {
+		std::vector<CUnit *> &units = this->resource_units[unit->GivesResource];
+		const auto find_iterator = std::find(units.begin(), units.end(), unit);
+
+		if (find_iterator != units.end()) {
+			*find_iterator = units.back();
+			units.pop_back();
+			return;
+		}
+	}
+
+	//the unit's given resource may have changed without the index being told, so look for it in the other lists
+	for (std::vector<CUnit *> &units : this->resource_units) {
+		const auto find_iterator = std::find(units.begin(), units.end(), unit);
+
+		if (find_iterator != units.end()) {
+			*find_iterator = units.back();
+			units.pop_back();
+			return;
+		}
+	}
+}
+
+void resource_index::on_unit_given_resource_changed(CUnit *unit, const int old_resource_index)
+{
+	if (old_resource_index < static_cast<int>(this->resource_units.size())) {
+		std::vector<CUnit *> &units = this->resource_units[old_resource_index];
+		const auto find_iterator = std::find(units.begin(), units.end(), unit);
+
+		if (find_iterator != units.end()) {
+			*find_iterator = units.back();
+			units.pop_back();
+		}
+	}
+
+	this->insert_unit(unit);
+}
+
+const std::vector<CUnit *> &resource_index::get_resource_units(const resource *resource) const
+{
+	static const std::vector<CUnit *> empty_vector;
+
+	if (resource->get_index() >= static_cast<int>(this->resource_units.size())) {
+		return empty_vector;
+	}
+
+	return this->resource_units[resource->get_index()];
+}
+
+void resource_index::on_tile_changed(const QPoint &tile_pos)
+{
+	if (this->dirty) {
+		//will be indexed anyway
+		return;
+	}
+
+	const int tile_index = tile_pos.x() + tile_pos.y() * this->map_size.width();
+	const resource *old_resource = this->tile_resources[tile_index];
+	const resource *resource = this->get_tile_resource(tile_index);
+
+	if (resource == old_resource) {
+		return;
+	}
+
+	if (old_resource != nullptr) {
+		this->remove_tile(tile_index, old_resource);
+	}
+
+	if (resource != nullptr) {
+		this->insert_tile(tile_index, resource);
+	}
+}
+
+void resource_index::calculate_tiles()
+{
+	const int tile_count = this->map_size.width() * this->map_size.height();
+
+	this->resource_tile_buckets.clear();
+	this->tile_resources.assign(tile_count, nullptr);
+
+	for (int tile_index = 0; tile_index < tile_count; ++tile_index) {
+		const resource *resource = this->get_tile_resource(tile_index);
+
+		if (resource != nullptr) {
+			this->insert_tile(tile_index, resource);
+		}
+	}
+
+	this->dirty = false;
+}
+
+void resource_index::insert_tile(const int tile_index, const resource *resource)
+{
+	std::vector<std::vector<int>> &buckets = this->resource_tile_buckets[resource];
+
+	if (buckets.empty()) {
+		buckets.resize(this->bucket_grid_size.width() * this->bucket_grid_size.height());
+	}
+
+	buckets[this->get_tile_bucket_index(tile_index)].push_back(tile_index);
+
+	this->tile_resources[tile_index] = resource;
+}
+
+void resource_index::remove_tile(const int tile_index, const resource *resource)
+{
+	std::vector<int> &bucket = this->resource_tile_buckets[resource][this->get_tile_bucket_index(tile_index)];
+
+	//the order of the tiles in a bucket doesn't matter, as searches order them by distance and index, so the removed tile can be swapped with the last one
+	const auto find_iterator = std::find(bucket.begin(), bucket.end(), tile_index);
+	if (find_iterator != bucket.end()) {
+		*find_iterator = bucket.back();
+		bucket.pop_back();
+	}
+
+	this->tile_resources[tile_index] = nullptr;
+}
+
+int resource_index::get_tile_bucket_index(const int tile_index) const
+{
+	const int bucket_x = (tile_index % this->map_size.width()) / resource_index::bucket_size;
+	const int bucket_y = (tile_index / this->map_size.width()) / resource_index::bucket_size;
+
+	return bucket_x + bucket_y * this->bucket_grid_size.width();
+}
+
+const resource *resource_index::get_tile_resource(const int tile_index) const
+{
+	return this->map_layer->Field(tile_index)->get_resource();
+}
+
+}
@@ -0,0 +1,146 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#pragma once
+
+class CMapLayer;
+class CUnit;
+
+namespace wyrmgus {
+
+class resource;
+
+//an index of the resource tiles and resource units of a map layer, so that searches for resources can go through the resources themselves instead of flood-filling the terrain around the searching unit
+//the tiles of each resource are kept in square buckets, so that they can be gone through in order of distance; the units are kept in a list per given resource, since there are few of them
+class resource_index final
+{
+public:
+	static constexpr int bucket_size = 8; //the width and height of a bucket, in tiles
+
+	explicit resource_index(const CMapLayer *map_layer);
+
+	void insert_unit(CUnit *unit);
+	void remove_unit(CUnit *unit);
+	void on_unit_given_resource_changed(CUnit *unit, const int old_resource_index);
+
+	//get the units on the map layer which give a resource
+	const std::vector<CUnit *> &get_resource_units(const resource *resource) const;
+
+	void on_tile_changed(const QPoint &tile_pos);
+
+	//call a function for the tiles of a resource in order of their (Chebyshev) distance to a position, until it returns true for one of them, which is then set as the result
+	//tiles at the same distance are gone through in order of their index; tiles beyond the max distance are ignored
+	template <typename function_type>
+	bool find_resource_tile(const QPoint &start_pos, const int max_distance, const resource *resource, const function_type &function, QPoint &result_pos)
+	{
+		if (this->dirty) {
+			this->calculate_tiles();
+		}
+
+		const auto find_iterator = this->resource_tile_buckets.find(resource);
+		if (find_iterator == this->resource_tile_buckets.end()) {
+			return false;
+		}
+
+		const std::vector<std::vector<int>> &buckets = find_iterator->second;
+		const QPoint start_bucket_pos(start_pos.x() / resource_index::bucket_size, start_pos.y() / resource_index::bucket_size);
+		const int max_ring = std::min((max_distance + resource_index::bucket_size - 1) / resource_index::bucket_size, std::max(this->bucket_grid_size.width(), this->bucket_grid_size.height()));
+
+		//pairs of distance and tile index
+		std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> candidates;
+
+		const auto check_candidates = [&](const int max_candidate_distance) {
+			while (!candidates.empty() && candidates.top().first <= max_candidate_distance) {
+				const int tile_index = candidates.top().second;
+				candidates.pop();
+
+				const QPoint tile_pos(tile_index % this->map_size.width(), tile_index / this->map_size.width());
+
+				if (this->get_tile_resource(tile_index) != resource) {
+					//the tile's terrain was changed without the index being told
+					continue;
+				}
+
+				if (function(tile_pos)) {
+					result_pos = tile_pos;
+					return true;
+				}
+			}
+
+			return false;
+		};
+
+		for (int ring = 0; ring <= max_ring; ++ring) {
+			const int top = start_bucket_pos.y() - ring;
+			const int bottom = start_bucket_pos.y() + ring;
+
+			for (int bucket_y = std::max(top, 0); bucket_y <= std::min(bottom, this->bucket_grid_size.height() - 1); ++bucket_y) {
+				//only the buckets on the edges of the ring's square are in the ring
+				const int x_step = (bucket_y == top || bucket_y == bottom) ? 1 : std::max(ring * 2, 1);
+
+				for (int bucket_x = start_bucket_pos.x() - ring; bucket_x <= start_bucket_pos.x() + ring; bucket_x += x_step) {
+					if (bucket_x < 0 || bucket_x >= this->bucket_grid_size.width()) {
+						continue;
+					}
+
+					for (const int tile_index : buckets[bucket_x + bucket_y * this->bucket_grid_size.width()]) {
+						const int distance = std::max(std::abs(tile_index % this->map_size.width() - start_pos.x()), std::abs(tile_index / this->map_size.width() - start_pos.y()));
+
+						if (distance <= max_distance) {
+							candidates.emplace(distance, tile_index);
+						}
+					}
+				}
+			}
+
+			//the tiles of the buckets of the next ring are further away than this
+			if (check_candidates(ring * resource_index::bucket_size)) {
+				return true;
+			}
+		}
+
+		return check_candidates(max_distance);
+	}
+
+private:
+	void calculate_tiles();
+	void insert_tile(const int tile_index, const resource *resource);
+	void remove_tile(const int tile_index, const resource *resource);
+	int get_tile_bucket_index(const int tile_index) const;
+	const resource *get_tile_resource(const int tile_index) const;
+
+private:
+	const CMapLayer *map_layer = nullptr;
+	QSize map_size;
+	QSize bucket_grid_size;
+	std::vector<std::vector<CUnit *>> resource_units; //the units giving each resource, by resource index
+	std::map<const resource *, std::vector<std::vector<int>>> resource_tile_buckets; //the indexes of the tiles of each resource, per bucket
+	std::vector<const resource *> tile_resources; //the resource under which each tile is indexed
+	bool dirty = true; //the tiles are only indexed when first needed, as the terrain is set without notifications while the map is being created
+};
+
+}
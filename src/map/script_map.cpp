@@ -246,7 +246,7 @@ static int CclStratagusMap(lua_State *l)
 							if (mf.is_destroyed_tree_tile()) {
 								map_layer->destroyed_tree_tiles.push_back(map_layer->GetPosFromIndex(i));
 							} else if (mf.get_overlay_terrain() != nullptr && mf.OverlayTerrainDestroyed) {
-								map_layer->destroyed_overlay_terrain_tiles.push_back(map_layer->GetPosFromIndex(i));
+								map_layer->add_destroyed_overlay_terrain_tile(map_layer->GetPosFromIndex(i));
 							}
 							lua_pop(l, 1);
 						}
@@ -405,6 +405,18 @@ static int CclGetFogOfWar(lua_State *l)
 	return 1;
 }
 
+/**
+**  Enable or disable the comparison of the sight obstacle results with those of CheckObstaclesBetweenTiles.
+**
+**  @param l  Lua state.
+*/
+static int CclSetSightValidation(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	ValidateSightObstacles = LuaToBoolean(l, 1);
+	return 0;
+}
+
 /**
 **  Fog of war opacity.
 **
@@ -1791,6 +1803,7 @@ void MapCclRegister()
 
 	lua_register(Lua, "SetFogOfWar", CclSetFogOfWar);
 	lua_register(Lua, "GetFogOfWar", CclGetFogOfWar);
+	lua_register(Lua, "SetSightValidation", CclSetSightValidation);
 
 	lua_register(Lua, "SetFogOfWarGraphics", CclSetFogOfWarGraphics);
 	lua_register(Lua, "SetFogOfWarOpacity", CclSetFogOfWarOpacity);
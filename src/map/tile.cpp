@@ -96,6 +96,18 @@ bool tile::has_flag(const tile_flag flag) const
 	return (this->get_flags() & flag) != tile_flag::none;
 }
 
+bool tile::is_passable_ignoring_mobile_units(const tile_flag movement_mask) const
+{
+	tile_flag flags = this->get_flags();
+
+	//as in the A* cost calculation, don't count water and coast flags if there is a bridge present
+	if ((flags & tile_flag::bridge) != tile_flag::none) {
+		flags &= ~(tile_flag::water_allowed | tile_flag::coast_allowed);
+	}
+
+	return (flags & movement_mask & ~(tile_flag::land_unit | tile_flag::air_unit | tile_flag::sea_unit)) == tile_flag::none;
+}
+
 //Wyrmgus start
 /**
 **	@brief	Set the tile's terrain type
@@ -398,7 +410,7 @@ void tile::Save(CFile &file) const
 	exploration_str.resize(PlayerMax);
 	int last_explored_index = -1;
 	for (int i = 0; i != PlayerMax; ++i) {
-		if (player_info->Visible[i] == 1) {
+		if (player_info->get_visibility(i) == 1) {
 			exploration_str[i] = '1';
 			last_explored_index = i;
 		} else {
@@ -624,7 +636,7 @@ void tile::parse(lua_State *l)
 
 			for (size_t p = 0; p < exploration_str.size(); ++p) {
 				if (exploration_str[p] == '1') {
-					this->player_info->Visible[p] = 1;
+					this->player_info->set_visibility(p, 1);
 				}
 			}
 		} else if (!strcmp(value, "land")) {
@@ -833,61 +845,36 @@ void tile::bump_incompatible_units()
 
 unsigned char tile_player_info::TeamVisibilityState(const CPlayer &player) const
 {
-	if (this->IsVisible(player)) {
-		return 2;
-	}
-
-	unsigned char maxVision = 0;
-
-	if (this->IsExplored(player)) {
-		maxVision = 1;
-	}
+	//the team vision mask contains the player itself and the players which share vision mutually with it; revealed players' tiles are only shown while they are currently visible, not when they have merely been explored
+	const uint64_t team_vision_mask = player.get_team_vision_mask();
 
-	const int player_index = player.Index;
-	for (const int i : player.get_shared_vision()) {
-		if (CPlayer::Players[i]->has_shared_vision_with(player_index)) { //if the shared vision is mutual
-			maxVision = std::max<unsigned char>(maxVision, this->Visible[i]);
-			if (maxVision >= 2) {
-				return 2;
-			}
-		}
-	}
-
-	for (const CPlayer *other_player : CPlayer::get_revealed_players()) {
-		const int other_player_index = other_player->Index;
-		if (this->Visible[other_player_index] < 2) { //don't show a revealed player's explored tiles, only the currently visible ones
-			continue;
-		}
-
-		maxVision = std::max<unsigned char>(maxVision, Visible[other_player_index]);
-		if (maxVision >= 2) {
-			return 2;
-		}
+	if ((this->get_visible_mask() & (team_vision_mask | CPlayer::get_revealed_player_mask())) != 0) {
+		return 2;
 	}
 
-	if (maxVision == 1 && CMap::Map.NoFogOfWar) {
-		return 2;
+	if ((this->get_explored_mask() & team_vision_mask) != 0) {
+		return CMap::Map.NoFogOfWar ? 2 : 1;
 	}
 
-	return maxVision;
+	return 0;
 }
 
 bool tile_player_info::IsExplored(const CPlayer &player) const
 {
-	return Visible[player.Index] != 0;
+	return this->get_visibility(player.Index) != 0;
 }
 
 //Wyrmgus start
 bool tile_player_info::IsTeamExplored(const CPlayer &player) const
 {
-	return Visible[player.Index] != 0 || TeamVisibilityState(player) != 0;
+	return TeamVisibilityState(player) != 0;
 }
 //Wyrmgus end
 
 bool tile_player_info::IsVisible(const CPlayer &player) const
 {
 	const bool fogOfWar = !CMap::Map.NoFogOfWar;
-	return Visible[player.Index] >= 2 || (!fogOfWar && IsExplored(player));
+	return this->get_visibility(player.Index) >= 2 || (!fogOfWar && IsExplored(player));
 }
 
 bool tile_player_info::IsTeamVisible(const CPlayer &player) const
@@ -33,23 +33,26 @@
 **    This is the tile number, that the player sitting on the computer
 **    currently knows. Idea: Can be uses for illusions.
 **
-**  tile_player_info::Visible[]
+**  tile_player_info::get_visibility()
 **
 **    Counter how many units of the player can see this field. 0 the
 **    field is not explored, 1 explored, n-1 unit see it. Currently
 **    no more than 253 units can see a field.
 **
-**  tile_player_info::VisCloak[]
+**  tile_player_info::get_cloak_visibility()
 **
 **    Visiblity for cloaking.
 **
-**  tile_player_info::Radar[]
+**  tile_player_info::get_radar()
 **
 **    Visiblity for radar.
 **
-**  tile_player_info::RadarJammer[]
+**  tile_player_info::get_radar_jammer()
 **
 **    Jamming capabilities.
+**
+**  The counters are not stored in the tile itself, but in the
+**  visibility planes of its map layer, one per player in the game.
 */
 
 /**
@@ -108,6 +111,7 @@
 **    top and right most map coordinate.
 */
 
+#include "map/visibility_planes.h"
 #include "unit/unit_cache.h"
 #include "vec2i.h"
 
@@ -161,11 +165,83 @@ public:
 	std::vector<std::pair<const wyrmgus::terrain_type *, short>> SeenTransitionTiles;			/// Transition tiles; the pair contains the terrain type and the tile index
 	std::vector<std::pair<const wyrmgus::terrain_type *, short>> SeenOverlayTransitionTiles;		/// Overlay transition tiles; the pair contains the terrain type and the tile index
 	//Wyrmgus end
-	std::array<unsigned short, PlayerMax> Visible = {};    /// Seen counter 0 unexplored
-	std::array<unsigned char, PlayerMax> VisCloak = {};    /// Visiblity for cloaking.
-	std::array<unsigned char, PlayerMax> VisEthereal = {};    /// Visiblity for ethereal.
-	std::array<unsigned char, PlayerMax> Radar = {};       /// Visiblity for radar.
-	std::array<unsigned char, PlayerMax> RadarJammer = {}; /// Jamming capabilities.
+
+	void set_visibility_planes(visibility_planes *planes, const unsigned int tile_index)
+	{
+		this->planes = planes;
+		this->tile_index = tile_index;
+	}
+
+	unsigned short get_visibility(const int player_index) const
+	{
+		const player_visibility_plane *plane = this->planes->get_plane(player_index);
+		return plane != nullptr ? plane->visible[this->tile_index] : 0;
+	}
+
+	void set_visibility(const int player_index, const unsigned short visibility)
+	{
+		this->planes->set_visibility(player_index, this->tile_index, visibility);
+	}
+
+	//get the mask of the players which currently see the tile
+	uint64_t get_visible_mask() const
+	{
+		return this->planes->get_visible_mask(this->tile_index);
+	}
+
+	//get the mask of the players which have explored the tile
+	uint64_t get_explored_mask() const
+	{
+		return this->planes->get_explored_mask(this->tile_index);
+	}
+
+	unsigned char get_cloak_visibility(const int player_index) const
+	{
+		const player_visibility_plane *plane = this->planes->get_plane(player_index);
+		return plane != nullptr ? plane->cloak[this->tile_index] : 0;
+	}
+
+	unsigned char &get_cloak_visibility_counter(const int player_index)
+	{
+		return this->planes->get_or_create_plane(player_index).cloak[this->tile_index];
+	}
+
+	unsigned char get_ethereal_visibility(const int player_index) const
+	{
+		const player_visibility_plane *plane = this->planes->get_plane(player_index);
+		return plane != nullptr ? plane->ethereal[this->tile_index] : 0;
+	}
+
+	unsigned char &get_ethereal_visibility_counter(const int player_index)
+	{
+		return this->planes->get_or_create_plane(player_index).ethereal[this->tile_index];
+	}
+
+	unsigned char get_radar(const int player_index) const
+	{
+		const player_visibility_plane *plane = this->planes->get_plane(player_index);
+		return plane != nullptr ? plane->radar[this->tile_index] : 0;
+	}
+
+	unsigned char &get_radar_counter(const int player_index)
+	{
+		return this->planes->get_or_create_plane(player_index).radar[this->tile_index];
+	}
+
+	unsigned char get_radar_jammer(const int player_index) const
+	{
+		const player_visibility_plane *plane = this->planes->get_plane(player_index);
+		return plane != nullptr ? plane->radar_jammer[this->tile_index] : 0;
+	}
+
+	unsigned char &get_radar_jammer_counter(const int player_index)
+	{
+		return this->planes->get_or_create_plane(player_index).radar_jammer[this->tile_index];
+	}
+
+private:
+	visibility_planes *planes = nullptr; //the visibility planes of the tile's map layer, which hold the per-player visibility counters
+	unsigned int tile_index = 0; //the index of the tile in the visibility planes
 };
 
 /// Describes a field of the map
@@ -254,6 +330,9 @@ public:
 
 	bool has_flag(const tile_flag flag) const;
 
+	//get whether the tile can be crossed with a movement mask, ignoring units which aren't buildings, as they can move away
+	bool is_passable_ignoring_mobile_units(const tile_flag movement_mask) const;
+
 	unsigned char get_movement_cost() const
 	{
 		return this->movement_cost;
@@ -0,0 +1,110 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#pragma once
+
+namespace wyrmgus {
+
+//the visibility counters of a player for each tile of a map layer, stored contiguously, so that fog of war and minimap sweeps stream through memory
+struct player_visibility_plane final
+{
+	explicit player_visibility_plane(const size_t tile_count)
+		: visible(tile_count, 0), cloak(tile_count, 0), ethereal(tile_count, 0), radar(tile_count, 0), radar_jammer(tile_count, 0)
+	{
+	}
+
+	std::vector<unsigned short> visible; //seen counter, 0 for unexplored, 1 for explored, and n - 1 units seeing the tile
+	std::vector<unsigned char> cloak; //visibility for cloaking
+	std::vector<unsigned char> ethereal; //visibility for ethereal
+	std::vector<unsigned char> radar; //visibility for radar
+	std::vector<unsigned char> radar_jammer; //jamming capabilities
+};
+
+//the per-player visibility planes of a map layer; a plane is only allocated when something first marks the map layer for its player, so players which aren't in the game take no memory
+//for each tile, masks of the players which see or have explored it are kept as well, with each player being represented as one bit, so that team visibility can be checked without going through the players
+class visibility_planes final
+{
+public:
+	static_assert(PlayerMax <= 64);
+
+	explicit visibility_planes(const size_t tile_count)
+		: tile_count(tile_count), visible_masks(tile_count, 0), explored_masks(tile_count, 0)
+	{
+	}
+
+	const player_visibility_plane *get_plane(const int player_index) const
+	{
+		return this->planes[player_index].get();
+	}
+
+	player_visibility_plane &get_or_create_plane(const int player_index)
+	{
+		std::unique_ptr<player_visibility_plane> &plane = this->planes[player_index];
+
+		if (plane == nullptr) {
+			plane = std::make_unique<player_visibility_plane>(this->tile_count);
+		}
+
+		return *plane;
+	}
+
+	void set_visibility(const int player_index, const size_t tile_index, const unsigned short visibility)
+	{
+		this->get_or_create_plane(player_index).visible[tile_index] = visibility;
+
+		const uint64_t player_bit = static_cast<uint64_t>(1) << player_index;
+
+		if (visibility >= 2) {
+			this->visible_masks[tile_index] |= player_bit;
+		} else {
+			this->visible_masks[tile_index] &= ~player_bit;
+		}
+
+		if (visibility != 0) {
+			this->explored_masks[tile_index] |= player_bit;
+		} else {
+			this->explored_masks[tile_index] &= ~player_bit;
+		}
+	}
+
+	uint64_t get_visible_mask(const size_t tile_index) const
+	{
+		return this->visible_masks[tile_index];
+	}
+
+	uint64_t get_explored_mask(const size_t tile_index) const
+	{
+		return this->explored_masks[tile_index];
+	}
+
+private:
+	size_t tile_count = 0;
+	std::array<std::unique_ptr<player_visibility_plane>, PlayerMax> planes;
+	std::vector<uint64_t> visible_masks; //the players which currently see each tile
+	std::vector<uint64_t> explored_masks; //the players which have explored each tile
+};
+
+}
@@ -38,7 +38,9 @@
 #include "unit/unit.h"
 #include "unit/unit_find.h"
 #include "unit/unit_type_type.h"
+#include "util/circle_util.h"
 #include "util/number_util.h"
+#include "util/thread_pool.h"
 #include "util/vector_util.h"
 
 #include "pathfinder.h"
@@ -48,11 +50,15 @@ struct Node {
 	short int CostToGoal = 0;     /// Estimated cost to goal
 	char InGoal = 0;        /// is this point in the goal
 	char Direction = 0;     /// Direction for trace back
+	int OpenIndex = -1;     /// Position of this point in the open set heap, or -1 if it is not in the open set
 };
 
 struct Open {
 	Vec2i pos = Vec2i(0, 0);
 	short int Costs = 0; /// complete costs to goal
+	short int CostToGoal = 0; /// estimated cost to goal, used for tie-breaking
+	int Dist = 0; /// Manhattan distance to goal, used for tie-breaking
+	unsigned int Sequence = 0; /// order in which the node was added to the open set, used as the final tie-break
 	//Wyrmgus start
 //	unsigned short int O = 0;     /// Offset into matrix
 	unsigned int O = 0;     /// Offset into matrix
@@ -72,19 +78,6 @@ std::array<std::vector<int>, 9> Heading2O;//heading to offset
 //Wyrmgus end
 static constexpr std::array<std::array<int, 3>, 3> XY2Heading = { { {7, 6, 5}, {0, 0, 4}, {1, 2, 3} } };
 
-/// cost matrix
-//Wyrmgus start
-//static std::vector<Node> AStarMatrix;
-static std::vector<std::vector<Node>> AStarMatrix;
-//Wyrmgus end
-
-/// a list of close nodes, helps to speed up the matrix cleaning
-//Wyrmgus start
-//static std::vector<int> CloseSet;
-//static size_t Threshold = 0;
-static std::vector<std::vector<int>> CloseSet;
-static std::vector<size_t> Threshold;
-//Wyrmgus end
 static constexpr int MAX_CLOSE_SET_RATIO = 4;
 static constexpr int MAX_OPEN_SET_RATIO = 8; // 10,16 to small
 
@@ -101,25 +94,87 @@ static std::vector<int> AStarMapWidth;
 static std::vector<int> AStarMapHeight;
 //Wyrmgus end
 
-static int AStarGoalX;
-static int AStarGoalY;
+/// maximum size of the close set before the whole matrix is cleaned instead
+//Wyrmgus start
+//static size_t Threshold = 0;
+static std::vector<size_t> Threshold;
+//Wyrmgus end
+
+static constexpr int CacheNotSet = -5;
 
 /**
-**  The Open set is handled by a stored array
-**  the end of the array holds the item with the smallest cost.
+**  The buffers used by an A* search
+**
+**  Each context owns its own buffers, so that searches using different contexts can run at the same time.
+**  The buffers for a map layer are only allocated when the context is first used for a search in that layer.
+**
+**  The Open set is handled by a binary min-heap
+**  the start of the array holds the item with the smallest cost;
+**  the position of each item in the heap is kept in the cost matrix, so that it can be found and updated without scanning the set.
 */
+class astar_context final
+{
+public:
+	astar_context()
+		: matrix(AStarMapWidth.size()), close_set(AStarMapWidth.size()),
+		open_set(AStarMapWidth.size()), cost_move_to_cache(AStarMapWidth.size())
+	{
+	}
 
-/// The set of Open nodes
-//Wyrmgus start
-//static std::vector<Open> OpenSet;
-static std::vector<std::vector<Open>> OpenSet;
-//Wyrmgus end
+	void prepare_map_layer(const int z)
+	{
+		if (!this->matrix[z].empty()) {
+			return;
+		}
 
-//Wyrmgus start
-//static std::vector<int> CostMoveToCache;
-static std::vector<std::vector<int>> CostMoveToCache;
-//Wyrmgus end
-static constexpr int CacheNotSet = -5;
+		const size_t tile_count = static_cast<size_t>(AStarMapWidth[z] * AStarMapHeight[z]);
+
+		this->matrix[z].resize(tile_count);
+		this->close_set[z].reserve(Threshold[z]);
+		this->open_set[z].reserve(tile_count / MAX_OPEN_SET_RATIO);
+		this->cost_move_to_cache[z].resize(tile_count, CacheNotSet);
+	}
+
+	std::vector<std::vector<Node>> matrix; /// cost matrix
+	std::vector<std::vector<int>> close_set; /// a list of close nodes, helps to speed up the matrix cleaning
+	std::vector<std::vector<Open>> open_set; /// the set of open nodes
+	std::vector<std::vector<int>> cost_move_to_cache;
+	Vec2i goal_pos = Vec2i(0, 0);
+	unsigned int open_sequence = 0; /// the sequence number of the next node added to the open set
+};
+
+/// all the A* contexts, the first one is used by AStarFindPath
+static std::vector<std::unique_ptr<astar_context>> AStarContexts;
+/// the contexts which are available to AStarFindPaths
+static std::vector<astar_context *> AStarFreeContexts;
+static std::mutex AStarContextMutex;
+
+/**
+**  Get a context which isn't being used by any other search, creating a new one if necessary
+*/
+static astar_context *AStarAcquireContext()
+{
+	std::lock_guard<std::mutex> lock(AStarContextMutex);
+
+	if (AStarFreeContexts.empty()) {
+		AStarContexts.push_back(std::make_unique<astar_context>());
+		return AStarContexts.back().get();
+	}
+
+	astar_context *context = AStarFreeContexts.back();
+	AStarFreeContexts.pop_back();
+	return context;
+}
+
+/**
+**  Make a context acquired with AStarAcquireContext available again
+*/
+static void AStarReleaseContext(astar_context *context)
+{
+	std::lock_guard<std::mutex> lock(AStarContextMutex);
+
+	AStarFreeContexts.push_back(context);
+}
 
 /**
 **  Init A* data structures
@@ -153,30 +208,25 @@ void InitAStar()
 	}
 	*/
 
+	// Should only be called once
+	Assert(AStarContexts.empty());
+
 	for (size_t z = 0; z < CMap::Map.MapLayers.size(); ++z) {
-		// Should only be called once
-		Assert(AStarMatrix.size() <= z);
-	
 		AStarMapWidth.push_back(CMap::Map.Info.MapWidths[z]);
 		AStarMapHeight.push_back(CMap::Map.Info.MapHeights[z]);
-		
-		AStarMatrix.push_back(std::vector<Node>(AStarMapWidth[z] * AStarMapHeight[z]));
 
 		const size_t threshold = static_cast<size_t>(AStarMapWidth[z] * AStarMapHeight[z] / MAX_CLOSE_SET_RATIO);
 		Threshold.push_back(threshold);
-		CloseSet.emplace_back();
-		CloseSet.back().reserve(threshold);
-
-		const size_t open_set_max_size = AStarMapWidth[z] * AStarMapHeight[z] / MAX_OPEN_SET_RATIO;
-		OpenSet.emplace_back();
-		OpenSet.back().reserve(open_set_max_size);
-
-		CostMoveToCache.push_back(std::vector<int>(AStarMapWidth[z] * AStarMapHeight[z], CacheNotSet));
 
 		for (int i = 0; i < 9; ++i) {
 			Heading2O[i].push_back(Heading2Y[i] * AStarMapWidth[z]);
 		}
 	}
+
+	AStarContexts.push_back(std::make_unique<astar_context>());
+	for (size_t z = 0; z < CMap::Map.MapLayers.size(); ++z) {
+		AStarContexts.front()->prepare_map_layer(z);
+	}
 	//Wyrmgus end
 }
 
@@ -194,11 +244,9 @@ void FreeAStar()
 	delete[] AStarMatrix;
 	AStarMatrix = nullptr;
 	*/
-	AStarMatrix.clear();
+	AStarFreeContexts.clear();
+	AStarContexts.clear();
 	Threshold.clear();
-	CloseSet.clear();
-	OpenSet.clear();
-	CostMoveToCache.clear();
 	
 	for (int i = 0; i < 9; ++i) {
 		Heading2O[i].clear();
@@ -211,12 +259,12 @@ void FreeAStar()
 */
 //Wyrmgus start
 //static void AStarPrepare()
-static void AStarPrepare(int z)
+static void AStarPrepare(astar_context &context, int z)
 //Wyrmgus end
 {
 	//Wyrmgus start
 //	wyrmgus::vector::fill(AStarMatrix, Node());
-	wyrmgus::vector::fill(AStarMatrix[z], Node());
+	wyrmgus::vector::fill(context.matrix[z], Node());
 	//Wyrmgus end
 }
 
@@ -225,31 +273,127 @@ static void AStarPrepare(int z)
 */
 //Wyrmgus start
 //static void AStarCleanUp()
-static void AStarCleanUp(int z)
+static void AStarCleanUp(astar_context &context, int z)
 //Wyrmgus end
 {
 	//Wyrmgus start
 //	if (CloseSet.size() >= Threshold) {
-	if (CloseSet[z].size() >= Threshold[z]) {
+	if (context.close_set[z].size() >= Threshold[z]) {
 	//Wyrmgus end
 		//Wyrmgus start
 //		AStarPrepare();
-		AStarPrepare(z);
+		AStarPrepare(context, z);
 		//Wyrmgus end
 	} else {
-		for (const int close : CloseSet[z]) {
-			AStarMatrix[z][close].CostFromStart = 0;
-			AStarMatrix[z][close].InGoal = 0;
+		for (const int close : context.close_set[z]) {
+			context.matrix[z][close].CostFromStart = 0;
+			context.matrix[z][close].InGoal = 0;
 		}
 	}
 }
 
 //Wyrmgus start
 //static void CostMoveToCacheCleanUp()
-static void CostMoveToCacheCleanUp(int z)
+static void CostMoveToCacheCleanUp(astar_context &context, int z)
 //Wyrmgus end
 {
-	wyrmgus::vector::fill(CostMoveToCache[z], CacheNotSet);
+	wyrmgus::vector::fill(context.cost_move_to_cache[z], CacheNotSet);
+}
+
+/**
+**  Whether the first open node should be expanded before the second one
+**
+**  Nodes are ordered by their complete costs, then by their estimated cost to goal, then by their Manhattan distance to the goal,
+**  and then by the order in which they were added, so that the search doesn't depend on how the heap happens to arrange equal nodes.
+*/
+static inline bool AStarOpenLess(const Open &lhs, const Open &rhs)
+{
+	if (lhs.Costs != rhs.Costs) {
+		return lhs.Costs < rhs.Costs;
+	}
+
+	if (lhs.CostToGoal != rhs.CostToGoal) {
+		return lhs.CostToGoal < rhs.CostToGoal;
+	}
+
+	if (lhs.Dist != rhs.Dist) {
+		return lhs.Dist < rhs.Dist;
+	}
+
+	return lhs.Sequence < rhs.Sequence;
+}
+
+/**
+**  Place an open node at a position in the heap, and record that position in the matrix
+*/
+static inline void AStarSetOpenNode(astar_context &context, const int pos, Open &&node, const int z)
+{
+	context.matrix[z][node.O].OpenIndex = pos;
+	context.open_set[z][pos] = std::move(node);
+}
+
+/**
+**  Move the node at the given heap position towards the top of the heap until the heap order is restored
+*/
+static void AStarSiftUp(astar_context &context, int pos, const int z)
+{
+	std::vector<Open> &open_set = context.open_set[z];
+	Open node = std::move(open_set[pos]);
+
+	while (pos > 0) {
+		const int parent = (pos - 1) / 2;
+		if (!AStarOpenLess(node, open_set[parent])) {
+			break;
+		}
+
+		AStarSetOpenNode(context, pos, std::move(open_set[parent]), z);
+		pos = parent;
+	}
+
+	AStarSetOpenNode(context, pos, std::move(node), z);
+}
+
+/**
+**  Move the node at the given heap position towards the bottom of the heap until the heap order is restored
+*/
+static void AStarSiftDown(astar_context &context, int pos, const int z)
+{
+	std::vector<Open> &open_set = context.open_set[z];
+	const int size = static_cast<int>(open_set.size());
+	Open node = std::move(open_set[pos]);
+
+	while (true) {
+		int child = pos * 2 + 1;
+		if (child >= size) {
+			break;
+		}
+
+		if (child + 1 < size && AStarOpenLess(open_set[child + 1], open_set[child])) {
+			++child;
+		}
+
+		if (!AStarOpenLess(open_set[child], node)) {
+			break;
+		}
+
+		AStarSetOpenNode(context, pos, std::move(open_set[child]), z);
+		pos = child;
+	}
+
+	AStarSetOpenNode(context, pos, std::move(node), z);
+}
+
+/**
+**  Empty the open node set, marking its nodes as no longer being in it
+*/
+static void AStarClearOpenSet(astar_context &context, const int z)
+{
+	for (const Open &open : context.open_set[z]) {
+		context.matrix[z][open.O].OpenIndex = -1;
+	}
+
+	context.open_set[z].clear();
+	context.open_sequence = 0;
 }
 
 /**
@@ -260,7 +404,9 @@ static void CostMoveToCacheCleanUp(int z)
 //#define AStarFindMinimum() (OpenSetSize - 1)
 static int AStarFindMinimum(const int z)
 {
-	return static_cast<int>(OpenSet[z].size()) - 1;
+	Q_UNUSED(z)
+
+	return 0;
 }
 //Wyrmgus end
 
@@ -269,18 +415,21 @@ static int AStarFindMinimum(const int z)
 */
 //Wyrmgus start
 //static void AStarRemoveMinimum(int pos)
-static void AStarRemoveMinimum(int pos, int z)
+static void AStarRemoveMinimum(astar_context &context, int pos, int z)
 //Wyrmgus end
 {
-	//Wyrmgus start
-//	Assert(pos == OpenSetSize - 1);
-	Assert(pos == static_cast<int>(OpenSet[z].size()) - 1);
-	//Wyrmgus end
+	Assert(pos == 0);
 
-	//Wyrmgus start
-//	OpenSetSize--;
-	OpenSet[z].pop_back();
-	//Wyrmgus end
+	std::vector<Open> &open_set = context.open_set[z];
+	context.matrix[z][open_set[pos].O].OpenIndex = -1;
+
+	Open last = std::move(open_set.back());
+	open_set.pop_back();
+
+	if (!open_set.empty()) {
+		open_set[pos] = std::move(last);
+		AStarSiftDown(context, pos, z);
+	}
 }
 
 /**
@@ -290,87 +439,40 @@ static void AStarRemoveMinimum(int pos, int z)
 */
 //Wyrmgus start
 //static inline int AStarAddNode(const Vec2i &pos, const int o, const int costs)
-static inline int AStarAddNode(const Vec2i &pos, const int o, const int costs, const int z)
+static inline int AStarAddNode(astar_context &context, const Vec2i &pos, const int o, const int costs, const int z)
 //Wyrmgus end
 {
-	int bigi = 0;
-	//Wyrmgus start
-//	int smalli = OpenSetSize;
-	int smalli = static_cast<int>(OpenSet[z].size());
-	//Wyrmgus end
-	int midcost;
-	int midi;
-	int midCostToGoal;
-	int midDist;
-
-	//Wyrmgus start
-//	const int costToGoal = AStarMatrix[o].CostToGoal;
-	const int costToGoal = AStarMatrix[z][o].CostToGoal;
-	//Wyrmgus end
-	const int dist = wyrmgus::number::fast_abs(pos.x - AStarGoalX) + wyrmgus::number::fast_abs(pos.y - AStarGoalY);
-
-	// find where we should insert this node.
-	// binary search where to insert the new node
-	while (bigi < smalli) {
-		midi = (smalli + bigi) >> 1;
-		//Wyrmgus start
-//		const Open &open = OpenSet[midi];
-		const Open &open = OpenSet[z][midi];
-		//Wyrmgus end
-		midcost = open.Costs;
-		//Wyrmgus start
-//		midCostToGoal = AStarMatrix[open.O].CostToGoal;
-		midCostToGoal = AStarMatrix[z][open.O].CostToGoal;
-		//Wyrmgus end
-		midDist = wyrmgus::number::fast_abs(open.pos.x - AStarGoalX) + wyrmgus::number::fast_abs(open.pos.y - AStarGoalY);
-		if (costs > midcost || (costs == midcost
-								&& (costToGoal > midCostToGoal || (costToGoal == midCostToGoal
-																   && dist > midDist)))) {
-			smalli = midi;
-		} else if (costs < midcost || (costs == midcost
-									   && (costToGoal < midCostToGoal || (costToGoal == midCostToGoal
-											   && dist < midDist)))) {
-			if (bigi == midi) {
-				bigi++;
-			} else {
-				bigi = midi;
-			}
-		} else {
-			bigi = midi;
-			smalli = midi;
-		}
-	}
-
 	// fill our new node
 	Open node;
 	node.pos = pos;
 	node.O = o;
 	node.Costs = costs;
-	//Wyrmgus start
-//	OpenSet.insert(OpenSet.begin() + bigi, std::move(node));
-	OpenSet[z].insert(OpenSet[z].begin() + bigi, std::move(node));
-	//Wyrmgus end
+	node.CostToGoal = context.matrix[z][o].CostToGoal;
+	node.Dist = wyrmgus::number::fast_abs(pos.x - context.goal_pos.x) + wyrmgus::number::fast_abs(pos.y - context.goal_pos.y);
+	node.Sequence = context.open_sequence++;
+
+	context.open_set[z].push_back(std::move(node));
+	AStarSiftUp(context, static_cast<int>(context.open_set[z].size()) - 1, z);
 
 	return 0;
 }
 
 /**
 **  Change the cost associated to an open node.
-**  Can be further optimised knowing that the new cost MUST BE LOWER
-**  than the old one.
+**  The new cost MUST BE LOWER than the old one, so the node can only move up in the heap.
 */
 //Wyrmgus start
 //static void AStarReplaceNode(int pos)
-static void AStarReplaceNode(int pos, int z)
+static void AStarReplaceNode(astar_context &context, int pos, int costs, int z)
 //Wyrmgus end
 {
-	Open node = wyrmgus::vector::take(OpenSet[z], static_cast<size_t>(pos));
+	Open &node = context.open_set[z][pos];
+	node.Costs = costs;
+	node.CostToGoal = context.matrix[z][node.O].CostToGoal;
+	//a replaced node counts as newly added, as when it was taken out and added again
+	node.Sequence = context.open_sequence++;
 
-	// Re-add the node with the new cost
-	//Wyrmgus start
-//	AStarAddNode(node.pos, node.O, node.Costs);
-	AStarAddNode(node.pos, node.O, node.Costs, z);
-	//Wyrmgus end
+	AStarSiftUp(context, pos, z);
 }
 
 /**
@@ -380,22 +482,10 @@ static void AStarReplaceNode(int pos, int z)
 */
 //Wyrmgus start
 //static int AStarFindNode(int eo)
-static int AStarFindNode(int eo, int z)
+static int AStarFindNode(const astar_context &context, int eo, int z)
 //Wyrmgus end
 {
-	//Wyrmgus start
-//	for (size_t i = 0; i < OpenSet.size(); ++i) {
-	for (size_t i = 0; i < OpenSet[z].size(); ++i) {
-	//Wyrmgus end
-		//Wyrmgus start
-//		if (OpenSet[i].O == eo) {
-		if (OpenSet[z][i].O == eo) {
-		//Wyrmgus end
-			return static_cast<int>(i);
-		}
-	}
-
-	return -1;
+	return context.matrix[z][eo].OpenIndex;
 }
 
 /**
@@ -403,16 +493,16 @@ static int AStarFindNode(int eo, int z)
 */
 //Wyrmgus start
 //static void AStarAddToClose(int node)
-static void AStarAddToClose(int node, int z)
+static void AStarAddToClose(astar_context &context, int node, int z)
 //Wyrmgus end
 {
 	//Wyrmgus start
 //	if (CloseSet.size() < Threshold) {
-	if (CloseSet[z].size() < Threshold[z]) {
+	if (context.close_set[z].size() < Threshold[z]) {
 	//Wyrmgus end
 		//Wyrmgus start
 //		CloseSet.push_back(node);
-		CloseSet[z].push_back(node);
+		context.close_set[z].push_back(node);
 		//Wyrmgus end
 	}
 }
@@ -546,7 +636,7 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit, int
 */
 //Wyrmgus start
 //static inline int CostMoveTo(unsigned int index, const CUnit &unit)
-static inline int CostMoveTo(unsigned int index, const CUnit &unit, int z)
+static inline int CostMoveTo(const astar_context &context, unsigned int index, const CUnit &unit, int z)
 //Wyrmgus end
 {
 	//Wyrmgus start
@@ -557,7 +647,7 @@ static inline int CostMoveTo(unsigned int index, const CUnit &unit, int z)
 	//Wyrmgus end
 	//Wyrmgus start
 //	int c = CostMoveToCache[index];
-	int c = CostMoveToCache[z][index];
+	int c = context.cost_move_to_cache[z][index];
 	//Wyrmgus end
 	if (c != CacheNotSet) {
 		return c;
@@ -572,8 +662,8 @@ static inline int CostMoveTo(unsigned int index, const CUnit &unit, int z)
 class AStarGoalMarker final
 {
 public:
-	explicit AStarGoalMarker(const CUnit &unit, bool &goal_reachable)
-		: unit(unit), goal_reachable(goal_reachable)
+	explicit AStarGoalMarker(astar_context &context, const CUnit &unit, bool &goal_reachable)
+		: context(context), unit(unit), goal_reachable(goal_reachable)
 	{
 	}
 
@@ -584,20 +674,21 @@ public:
 	{
 		//Wyrmgus start
 //		if (CostMoveTo(offset, unit) >= 0) {
-		if (CostMoveTo(offset, unit, z) >= 0) {
+		if (CostMoveTo(context, offset, unit, z) >= 0) {
 		//Wyrmgus end
 			//Wyrmgus start
 //			AStarMatrix[offset].InGoal = 1;
-			AStarMatrix[z][offset].InGoal = 1;
+			context.matrix[z][offset].InGoal = 1;
 			//Wyrmgus end
 			goal_reachable = true;
 		}
 		//Wyrmgus start
 //		AStarAddToClose(offset);
-		AStarAddToClose(offset, z);
+		AStarAddToClose(context, offset, z);
 		//Wyrmgus end
 	}
 private:
+	astar_context &context;
 	const CUnit &unit;
 	bool &goal_reachable;
 };
@@ -625,6 +716,8 @@ public:
 	{
 		this->minrange = minrange;
 		this->maxrange = maxrange;
+		this->max_range_row_half_widths = &wyrmgus::circle::get_row_half_widths(wyrmgus::circle::get_range_squared_radius(maxrange));
+		this->min_range_row_half_widths = &wyrmgus::circle::get_row_half_widths(wyrmgus::circle::get_range_squared_radius(minrange - 1));
 	}
 
 	void SetUnitSize(const Vec2i &tileSize)
@@ -643,9 +736,9 @@ public:
 	}
 
 private:
-	int GetMaxOffsetX(int dy, int range) const
+	int GetMaxOffsetX(int dy, const std::vector<int> *row_half_widths) const
 	{
-		return isqrt(square(range + 1) - square(dy) - 1);
+		return wyrmgus::circle::get_row_half_width(*row_half_widths, dy);
 	}
 
 	// Distance are computed between bottom of unit and top of goal
@@ -654,7 +747,7 @@ private:
 		const int miny = std::max(0, goalTopLeft.y - maxrange - unitExtraTileSize.y);
 		const int maxy = std::min(goalTopLeft.y - minrange - unitExtraTileSize.y, goalTopLeft.y - 1 - unitExtraTileSize.y);
 		for (int y = miny; y <= maxy; ++y) {
-			const int offsetx = GetMaxOffsetX(y - goalTopLeft.y, maxrange);
+			const int offsetx = GetMaxOffsetX(y - goalTopLeft.y, this->max_range_row_half_widths);
 			const int minx = std::max(0, goalTopLeft.x - offsetx - unitExtraTileSize.x);
 			//Wyrmgus start
 //			const int maxx = std::min(CMap::Map.Info.MapWidth - 1 - unitExtraTileSize.x, goalBottomRight.x + offsetx);
@@ -707,8 +800,8 @@ private:
 		const int miny = std::max(0, goalTopLeft.y - (minrange - 1) - unitExtraTileSize.y);
 		const int maxy = goalTopLeft.y - 1 - unitExtraTileSize.y;
 		for (int y = miny; y <= maxy; ++y) {
-			const int offsetmaxx = GetMaxOffsetX(y - goalTopLeft.y, maxrange);
-			const int offsetminx = GetMaxOffsetX(y - goalTopLeft.y, minrange - 1) + 1;
+			const int offsetmaxx = GetMaxOffsetX(y - goalTopLeft.y, this->max_range_row_half_widths);
+			const int offsetminx = GetMaxOffsetX(y - goalTopLeft.y, this->min_range_row_half_widths) + 1;
 
 			HemiCycleRing(y, offsetminx, offsetmaxx);
 		}
@@ -775,8 +868,8 @@ private:
 		//Wyrmgus end
 
 		for (int y = miny; y <= maxy; ++y) {
-			const int offsetmaxx = GetMaxOffsetX(y - goalBottomRight.y, maxrange);
-			const int offsetminx = GetMaxOffsetX(y - goalBottomRight.y, minrange - 1) + 1;
+			const int offsetmaxx = GetMaxOffsetX(y - goalBottomRight.y, this->max_range_row_half_widths);
+			const int offsetminx = GetMaxOffsetX(y - goalBottomRight.y, this->min_range_row_half_widths) + 1;
 
 			HemiCycleRing(y, offsetminx, offsetmaxx);
 		}
@@ -790,7 +883,7 @@ private:
 		const int maxy = std::min(CMap::Map.Info.MapHeights[z] - 1 - unitExtraTileSize.y, goalBottomRight.y + maxrange);
 		//Wyrmgus end
 		for (int y = miny; y <= maxy; ++y) {
-			const int offsetx = GetMaxOffsetX(y - goalBottomRight.y, maxrange);
+			const int offsetx = GetMaxOffsetX(y - goalBottomRight.y, this->max_range_row_half_widths);
 			const int minx = std::max(0, goalTopLeft.x - offsetx - unitExtraTileSize.x);
 			//Wyrmgus start
 //			const int maxx = std::min(CMap::Map.Info.MapWidth - 1 - unitExtraTileSize.x, goalBottomRight.x + offsetx);
@@ -818,6 +911,8 @@ private:
 	Vec2i unitExtraTileSize;
 	int minrange;
 	int maxrange;
+	const std::vector<int> *min_range_row_half_widths = nullptr;
+	const std::vector<int> *max_range_row_half_widths = nullptr;
 	//Wyrmgus start
 	int z;
 	//Wyrmgus end
@@ -828,7 +923,7 @@ private:
 /**
 **  MarkAStarGoal
 */
-static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
+static int AStarMarkGoal(astar_context &context, const Vec2i &goal, int gw, int gh,
 						 //Wyrmgus start
 //						 int tilesizex, int tilesizey, int minrange, int maxrange, const CUnit &unit)
 						 int tilesizex, int tilesizey, int minrange, int maxrange, const CUnit &unit, int z)
@@ -845,11 +940,11 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 //		unsigned int offset = GetIndex(goal.x, goal.y);
 //		if (CostMoveTo(offset, unit) >= 0) {
 		unsigned int offset = GetIndex(goal.x, goal.y, z);
-		if (CostMoveTo(offset, unit, z) >= 0) {
+		if (CostMoveTo(context, offset, unit, z) >= 0) {
 		//Wyrmgus end
 			//Wyrmgus start
 //			AStarMatrix[offset].InGoal = 1;
-			AStarMatrix[z][offset].InGoal = 1;
+			context.matrix[z][offset].InGoal = 1;
 			//Wyrmgus end
 			return 1;
 		} else {
@@ -862,7 +957,7 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 	gw = std::max(gw, 1);
 	gh = std::max(gh, 1);
 
-	AStarGoalMarker aStarGoalMarker(unit, goal_reachable);
+	AStarGoalMarker aStarGoalMarker(context, unit, goal_reachable);
 	MinMaxRangeVisitor<AStarGoalMarker> visitor(aStarGoalMarker);
 
 	const Vec2i goalBottomRigth(goal.x + gw - 1, goal.y + gh - 1);
@@ -888,7 +983,7 @@ static int AStarMarkGoal(const Vec2i &goal, int gw, int gh,
 */
 //Wyrmgus start
 //static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *path)
-static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *path, int z)
+static int AStarSavePath(const astar_context &context, const Vec2i &startPos, const Vec2i &endPos, std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *path, int z)
 //Wyrmgus end
 {
 	int fullPathLength;
@@ -905,7 +1000,7 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, std::array<
 	while (curr != startPos) {
 		//Wyrmgus start
 //		direction = AStarMatrix[currO + curr.x].Direction;
-		direction = AStarMatrix[z][currO + curr.x].Direction;
+		direction = context.matrix[z][currO + curr.x].Direction;
 		//Wyrmgus end
 		curr.x -= Heading2X[direction];
 		curr.y -= Heading2Y[direction];
@@ -928,7 +1023,7 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, std::array<
 		while (curr != startPos) {
 			//Wyrmgus start
 //			direction = AStarMatrix[currO + curr.x].Direction;
-			direction = AStarMatrix[z][currO + curr.x].Direction;
+			direction = context.matrix[z][currO + curr.x].Direction;
 			//Wyrmgus end
 			curr.x -= Heading2X[direction];
 			curr.y -= Heading2Y[direction];
@@ -950,7 +1045,7 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, std::array<
 **  Optimization to find a simple path
 **  Check if we're at the goal or if it's 1 tile away
 */
-static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw, int gh,
+static int AStarFindSimplePath(const astar_context &context, const Vec2i &startPos, const Vec2i &goal, int gw, int gh,
 							   int, int, int minrange, int maxrange,
 							   //Wyrmgus start
 //							   std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *path, const CUnit &unit)
@@ -983,7 +1078,7 @@ static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw,
 		// Move to adjacent cell
 		//Wyrmgus start
 //		if (CostMoveTo(GetIndex(goal.x, goal.y), unit) == -1) {
-		if (CostMoveTo(GetIndex(goal.x, goal.y, z), unit, z) == -1) {
+		if (CostMoveTo(context, GetIndex(goal.x, goal.y, z), unit, z) == -1) {
 		//Wyrmgus end
 			return PF_UNREACHABLE;
 		}
@@ -998,9 +1093,9 @@ static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw,
 }
 
 /**
-**  Find path.
+**  Find path, using the buffers of the given context.
 */
-int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
+static int AStarFindPath(astar_context &context, const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 				  int tilesizex, int tilesizey, int minrange, int maxrange,
 				  //Wyrmgus start
 //				  std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *path, const CUnit &unit)
@@ -1017,11 +1112,13 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	allow_diagonal = allow_diagonal && !unit.Type->BoolFlag[RAIL_INDEX].value; //rail units cannot move diagonally
 	//Wyrmgus end
 
-	AStarGoalX = goalPos.x;
-	AStarGoalY = goalPos.y;
+	context.prepare_map_layer(z);
+
+	context.goal_pos.x = goalPos.x;
+	context.goal_pos.y = goalPos.y;
 
 	//  Check for simple cases first
-	int ret = AStarFindSimplePath(startPos, goalPos, gw, gh, tilesizex, tilesizey,
+	int ret = AStarFindSimplePath(context, startPos, goalPos, gw, gh, tilesizex, tilesizey,
 								  //Wyrmgus start
 //								  minrange, maxrange, path, unit);
 								  minrange, maxrange, path, unit, z, allow_diagonal);
@@ -1034,20 +1131,20 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	//Wyrmgus start
 //	AStarCleanUp();
 //	CostMoveToCacheCleanUp();
-	AStarCleanUp(z);
-	CostMoveToCacheCleanUp(z);
+	AStarCleanUp(context, z);
+	CostMoveToCacheCleanUp(context, z);
 	//Wyrmgus end
 
 	//Wyrmgus start
 //	OpenSet.clear();
 //	CloseSet.clear();
-	OpenSet[z].clear();
-	CloseSet[z].clear();
+	AStarClearOpenSet(context, z);
+	context.close_set[z].clear();
 	//Wyrmgus end
 
 	//Wyrmgus start
 //	if (!AStarMarkGoal(goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, unit)) {
-	if (!AStarMarkGoal(goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, unit, z)) {
+	if (!AStarMarkGoal(context, goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, unit, z)) {
 	//Wyrmgus end
 		// goal is not reachable
 		ret = PF_UNREACHABLE;
@@ -1062,12 +1159,12 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	// 0 as a way to represent nodes that we have not visited yet.
 	//Wyrmgus start
 //	AStarMatrix[eo].CostFromStart = 1;
-	AStarMatrix[z][eo].CostFromStart = 1;
+	context.matrix[z][eo].CostFromStart = 1;
 	//Wyrmgus end
 	// 8 to say we are came from nowhere.
 	//Wyrmgus start
 //	AStarMatrix[eo].Direction = 8;
-	AStarMatrix[z][eo].Direction = 8;
+	context.matrix[z][eo].Direction = 8;
 	//Wyrmgus end
 
 	// place start point in open, it that failed, try another pathfinder
@@ -1075,8 +1172,8 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	//Wyrmgus start
 //	AStarMatrix[eo].CostToGoal = costToGoal;
 //	if (AStarAddNode(startPos, eo, 1 + costToGoal) == PF_FAILED) {
-	AStarMatrix[z][eo].CostToGoal = costToGoal;
-	if (AStarAddNode(startPos, eo, 1 + costToGoal, z) == PF_FAILED) {
+	context.matrix[z][eo].CostToGoal = costToGoal;
+	if (AStarAddNode(context, startPos, eo, 1 + costToGoal, z) == PF_FAILED) {
 	//Wyrmgus end
 		ret = PF_FAILED;
 		return ret;
@@ -1084,8 +1181,8 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	//Wyrmgus start
 //	AStarAddToClose(OpenSet[0].O);
 //	if (AStarMatrix[eo].InGoal) {
-	AStarAddToClose(OpenSet[z][0].O, z);
-	if (AStarMatrix[z][eo].InGoal) {
+	AStarAddToClose(context, context.open_set[z][0].O, z);
+	if (context.matrix[z][eo].InGoal) {
 	//Wyrmgus end
 		ret = PF_REACHED;
 		return ret;
@@ -1112,20 +1209,20 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 //		const int y = OpenSet[shortest].pos.y;
 //		const int o = OpenSet[shortest].O;
 		const int shortest = AStarFindMinimum(z);
-		const int x = OpenSet[z][shortest].pos.x;
-		const int y = OpenSet[z][shortest].pos.y;
-		const int o = OpenSet[z][shortest].O;
+		const int x = context.open_set[z][shortest].pos.x;
+		const int y = context.open_set[z][shortest].pos.y;
+		const int o = context.open_set[z][shortest].O;
 		//Wyrmgus end
 
 		//Wyrmgus start
 //		AStarRemoveMinimum(shortest);
-		AStarRemoveMinimum(shortest, z);
+		AStarRemoveMinimum(context, shortest, z);
 		//Wyrmgus end
 
 		// If we have reached the goal, then exit.
 		//Wyrmgus start
 //		if (AStarMatrix[o].InGoal == 1) {
-		if (AStarMatrix[z][o].InGoal == 1) {
+		if (context.matrix[z][o].InGoal == 1) {
 		//Wyrmgus end
 			endPos.x = x;
 			endPos.y = y;
@@ -1150,8 +1247,8 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 		//Wyrmgus start
 //		const int px = x - Heading2X[(int)AStarMatrix[o].Direction];
 //		const int py = y - Heading2Y[(int)AStarMatrix[o].Direction];
-		const int px = x - Heading2X[(int)AStarMatrix[z][o].Direction];
-		const int py = y - Heading2Y[(int)AStarMatrix[z][o].Direction];
+		const int px = x - Heading2X[(int)context.matrix[z][o].Direction];
+		const int py = y - Heading2Y[(int)context.matrix[z][o].Direction];
 		//Wyrmgus end
 
 		for (int i = 0; i < 8; ++i) {
@@ -1195,7 +1292,7 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 			// or if we have a better path to it, we add it to open set
 			//Wyrmgus start
 //			int new_cost = CostMoveTo(eo, unit);
-			int new_cost = CostMoveTo(eo, unit, z);
+			int new_cost = CostMoveTo(context, eo, unit, z);
 			//Wyrmgus end
 			if (new_cost == -1) {
 				// uncrossable tile
@@ -1207,22 +1304,22 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 			//Wyrmgus start
 //			new_cost += AStarMatrix[o].CostFromStart;
 //			if (AStarMatrix[eo].CostFromStart == 0) {
-			new_cost += AStarMatrix[z][o].CostFromStart;
-			if (AStarMatrix[z][eo].CostFromStart == 0) {
+			new_cost += context.matrix[z][o].CostFromStart;
+			if (context.matrix[z][eo].CostFromStart == 0) {
 			//Wyrmgus end
 				// we are sure the current node has not been already visited
 				//Wyrmgus start
 //				AStarMatrix[eo].CostFromStart = new_cost;
 //				AStarMatrix[eo].Direction = i;
-				AStarMatrix[z][eo].CostFromStart = new_cost;
-				AStarMatrix[z][eo].Direction = i;
+				context.matrix[z][eo].CostFromStart = new_cost;
+				context.matrix[z][eo].Direction = i;
 				//Wyrmgus end
 				costToGoal = AStarCosts(endPos, goalPos);
 				//Wyrmgus start
 //				AStarMatrix[eo].CostToGoal = costToGoal;
 //				if (AStarAddNode(endPos, eo, AStarMatrix[eo].CostFromStart + costToGoal) == PF_FAILED) {
-				AStarMatrix[z][eo].CostToGoal = costToGoal;
-				if (AStarAddNode(endPos, eo, AStarMatrix[z][eo].CostFromStart + costToGoal, z) == PF_FAILED) {
+				context.matrix[z][eo].CostToGoal = costToGoal;
+				if (AStarAddNode(context, endPos, eo, context.matrix[z][eo].CostFromStart + costToGoal, z) == PF_FAILED) {
 				//Wyrmgus end
 					ret = PF_FAILED;
 					return ret;
@@ -1230,32 +1327,32 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 				// we add the point to the close set
 				//Wyrmgus start
 //				AStarAddToClose(eo);
-				AStarAddToClose(eo, z);
+				AStarAddToClose(context, eo, z);
 				//Wyrmgus end
 			//Wyrmgus start
 //			} else if (new_cost < AStarMatrix[eo].CostFromStart) {
-			} else if (new_cost < AStarMatrix[z][eo].CostFromStart) {
+			} else if (new_cost < context.matrix[z][eo].CostFromStart) {
 			//Wyrmgus end
 				// Already visited node, but we have here a better path
 				// I know, it's redundant (but simpler like this)
 				//Wyrmgus start
 //				AStarMatrix[eo].CostFromStart = new_cost;
 //				AStarMatrix[eo].Direction = i;
-				AStarMatrix[z][eo].CostFromStart = new_cost;
-				AStarMatrix[z][eo].Direction = i;
+				context.matrix[z][eo].CostFromStart = new_cost;
+				context.matrix[z][eo].Direction = i;
 				//Wyrmgus end
 				// this point might be already in the OpenSet
 				//Wyrmgus start
 //				const int j = AStarFindNode(eo);
-				const int j = AStarFindNode(eo, z);
+				const int j = AStarFindNode(context, eo, z);
 				//Wyrmgus end
 				if (j == -1) {
 					costToGoal = AStarCosts(endPos, goalPos);
 					//Wyrmgus start
 //					AStarMatrix[eo].CostToGoal = costToGoal;
 //					if (AStarAddNode(endPos, eo, AStarMatrix[eo].CostFromStart + costToGoal) == PF_FAILED) {
-					AStarMatrix[z][eo].CostToGoal = costToGoal;
-					if (AStarAddNode(endPos, eo, AStarMatrix[z][eo].CostFromStart + costToGoal, z) == PF_FAILED) {
+					context.matrix[z][eo].CostToGoal = costToGoal;
+					if (AStarAddNode(context, endPos, eo, context.matrix[z][eo].CostFromStart + costToGoal, z) == PF_FAILED) {
 					//Wyrmgus end
 						ret = PF_FAILED;
 						return ret;
@@ -1265,8 +1362,8 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 					//Wyrmgus start
 //					AStarMatrix[eo].CostToGoal = costToGoal;
 //					AStarReplaceNode(j);
-					AStarMatrix[z][eo].CostToGoal = costToGoal;
-					AStarReplaceNode(j, z);
+					context.matrix[z][eo].CostToGoal = costToGoal;
+					AStarReplaceNode(context, j, context.matrix[z][eo].CostFromStart + costToGoal, z);
 					//Wyrmgus end
 				}
 				// we don't have to add this point to the close set
@@ -1274,7 +1371,7 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 		}
 		//Wyrmgus start
 //		if (OpenSet.size() <= 0) { // no new nodes generated
-		if (OpenSet[z].size() <= 0) { // no new nodes generated
+		if (context.open_set[z].size() <= 0) { // no new nodes generated
 		//Wyrmgus end
 			ret = PF_UNREACHABLE;
 			return ret;
@@ -1287,7 +1384,7 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 
 	//Wyrmgus start
 //	const int path_length = AStarSavePath(startPos, endPos, path);
-	const int path_length = AStarSavePath(startPos, endPos, path, z);
+	const int path_length = AStarSavePath(context, startPos, endPos, path, z);
 	//Wyrmgus end
 
 	ret = path_length;
@@ -1295,6 +1392,57 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
 	return ret;
 }
 
+/**
+**  Find path.
+*/
+int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
+				  int tilesizex, int tilesizey, int minrange, int maxrange,
+				  std::array<char, PathFinderOutput::MAX_PATH_LENGTH> *path, const CUnit &unit, int max_length, int z, bool allow_diagonal)
+{
+	if (wyrmgus::thread_pool::is_pool_thread()) {
+		//searches made from the thread pool, e.g. by units thinking in parallel, can't share the first context
+		astar_context *context = AStarAcquireContext();
+		const int result = AStarFindPath(*context, startPos, goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, path, unit, max_length, z, allow_diagonal);
+		AStarReleaseContext(context);
+		return result;
+	}
+
+	return AStarFindPath(*AStarContexts.front(), startPos, goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, path, unit, max_length, z, allow_diagonal);
+}
+
+/**
+**  Find paths for several requests at once, solving them in parallel.
+**
+**  The game state must not be changed while the paths are being found; the results are the same as if the requests had been solved one after another in their order.
+*/
+void AStarFindPaths(std::vector<AStarPathRequest> &requests)
+{
+	//if called from the thread pool, solve the requests one after another, since waiting for other tasks of the pool from within it could deadlock
+	if (requests.size() <= 1 || wyrmgus::thread_pool::is_pool_thread()) {
+		for (AStarPathRequest &request : requests) {
+			request.Result = AStarFindPath(request.StartPos, request.GoalPos, request.GoalSize.x, request.GoalSize.y, request.UnitSize.x, request.UnitSize.y, request.MinRange, request.MaxRange, request.Path, *request.Unit, request.MaxLength, request.MapLayer, request.AllowDiagonal);
+		}
+		return;
+	}
+
+	std::vector<std::future<void>> futures;
+	futures.reserve(requests.size());
+
+	for (AStarPathRequest &request : requests) {
+		std::future<void> future = wyrmgus::thread_pool::get()->async([&request]() {
+			astar_context *context = AStarAcquireContext();
+			request.Result = AStarFindPath(*context, request.StartPos, request.GoalPos, request.GoalSize.x, request.GoalSize.y, request.UnitSize.x, request.UnitSize.y, request.MinRange, request.MaxRange, request.Path, *request.Unit, request.MaxLength, request.MapLayer, request.AllowDiagonal);
+			AStarReleaseContext(context);
+		});
+
+		futures.push_back(std::move(future));
+	}
+
+	for (std::future<void> &future : futures) {
+		future.wait();
+	}
+}
+
 struct StatsNode {
 	int Direction = 0;
 	int InGoal = 0;
@@ -0,0 +1,494 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#include "stratagus.h"
+
+#include "pathfinder/cluster_graph.h"
+
+#include "map/map.h"
+#include "map/map_layer.h"
+#include "map/tile.h"
+#include "map/tile_flag.h"
+#include "pathfinder.h"
+#include "player.h"
+#include "unit/unit.h"
+#include "unit/unit_type.h"
+#include "util/point_util.h"
+
+namespace wyrmgus {
+
+static constexpr int unreachable_cost = std::numeric_limits<int>::max();
+
+static int get_chebyshev_distance(const QPoint &pos, const QRect &rect)
+{
+	const int dx = std::max({ rect.left() - pos.x(), 0, pos.x() - rect.right() });
+	const int dy = std::max({ rect.top() - pos.y(), 0, pos.y() - rect.bottom() });
+	return std::max(dx, dy);
+}
+
+cluster_graph::cluster_graph(const int z, const tile_flag movement_mask)
+	: z(z), movement_mask(movement_mask)
+{
+	this->map_size = CMap::get()->MapLayers[z]->get_size();
+	this->cluster_grid_size = QSize((this->map_size.width() - 1) / cluster_graph::cluster_size + 1, (this->map_size.height() - 1) / cluster_graph::cluster_size + 1);
+	this->clusters.resize(this->cluster_grid_size.width() * this->cluster_grid_size.height());
+}
+
+bool cluster_graph::is_tile_passable(const QPoint &tile_pos) const
+{
+	return CMap::get()->Field(tile_pos, this->z)->is_passable_ignoring_mobile_units(this->movement_mask);
+}
+
+int cluster_graph::get_tile_cost(const QPoint &tile_pos) const
+{
+	//add one for walking, as A* does
+	return CMap::get()->Field(tile_pos, this->z)->get_movement_cost() + 1;
+}
+
+QRect cluster_graph::get_cluster_rect(const QPoint &cluster_pos) const
+{
+	const QPoint top_left = cluster_pos * cluster_graph::cluster_size;
+	const QPoint bottom_right(std::min(top_left.x() + cluster_graph::cluster_size, this->map_size.width()) - 1, std::min(top_left.y() + cluster_graph::cluster_size, this->map_size.height()) - 1);
+	return QRect(top_left, bottom_right);
+}
+
+const cluster_graph::cluster &cluster_graph::get_cluster(const QPoint &cluster_pos)
+{
+	cluster &cluster = this->clusters[point::to_index(cluster_pos, this->cluster_grid_size)];
+
+	if (cluster.dirty) {
+		this->calculate_cluster(cluster_pos);
+	}
+
+	return cluster;
+}
+
+void cluster_graph::set_tile_dirty(const QPoint &tile_pos)
+{
+	const QPoint cluster_pos = this->get_cluster_pos(tile_pos);
+	this->clusters[point::to_index(cluster_pos, this->cluster_grid_size)].dirty = true;
+
+	//tiles on the border of a cluster also affect the entrances of the adjacent cluster
+	const QRect cluster_rect = this->get_cluster_rect(cluster_pos);
+	std::vector<QPoint> neighbor_cluster_positions;
+
+	if (tile_pos.x() == cluster_rect.left()) {
+		neighbor_cluster_positions.push_back(cluster_pos + QPoint(-1, 0));
+	} else if (tile_pos.x() == cluster_rect.right()) {
+		neighbor_cluster_positions.push_back(cluster_pos + QPoint(1, 0));
+	}
+
+	if (tile_pos.y() == cluster_rect.top()) {
+		neighbor_cluster_positions.push_back(cluster_pos + QPoint(0, -1));
+	} else if (tile_pos.y() == cluster_rect.bottom()) {
+		neighbor_cluster_positions.push_back(cluster_pos + QPoint(0, 1));
+	}
+
+	for (const QPoint &neighbor_cluster_pos : neighbor_cluster_positions) {
+		if (this->is_cluster_pos_valid(neighbor_cluster_pos)) {
+			this->clusters[point::to_index(neighbor_cluster_pos, this->cluster_grid_size)].dirty = true;
+		}
+	}
+}
+
+void cluster_graph::calculate_cluster(const QPoint &cluster_pos)
+{
+	cluster &cluster = this->clusters[point::to_index(cluster_pos, this->cluster_grid_size)];
+	cluster.nodes.clear();
+
+	//the entrance tiles in this cluster, mapped to the tiles in the adjacent clusters to which they lead
+	std::map<int, std::vector<int>> entrances;
+
+	static constexpr std::array<QPoint, 4> neighbor_offsets = { QPoint(0, -1), QPoint(-1, 0), QPoint(1, 0), QPoint(0, 1) };
+
+	for (const QPoint &offset : neighbor_offsets) {
+		const QPoint neighbor_cluster_pos = cluster_pos + offset;
+
+		if (!this->is_cluster_pos_valid(neighbor_cluster_pos)) {
+			continue;
+		}
+
+		this->add_border_entrances(cluster_pos, neighbor_cluster_pos, entrances);
+	}
+
+	for (const auto &[tile_index, neighbor_tile_indexes] : entrances) {
+		node node;
+		node.tile_index = tile_index;
+
+		for (const int neighbor_tile_index : neighbor_tile_indexes) {
+			node.edges.push_back({ neighbor_tile_index, this->get_tile_cost(point::from_index(neighbor_tile_index, this->map_size)) });
+		}
+
+		cluster.nodes.push_back(std::move(node));
+	}
+
+	const QRect cluster_rect = this->get_cluster_rect(cluster_pos);
+
+	for (node &node : cluster.nodes) {
+		const std::vector<int> costs = this->calculate_local_costs(cluster_rect, { point::from_index(node.tile_index, this->map_size) });
+
+		for (const cluster_graph::node &other_node : cluster.nodes) {
+			if (&other_node == &node) {
+				continue;
+			}
+
+			const QPoint local_pos = point::from_index(other_node.tile_index, this->map_size) - cluster_rect.topLeft();
+			const int cost = costs[point::to_index(local_pos, cluster_rect.size())];
+
+			if (cost != unreachable_cost) {
+				node.edges.push_back({ other_node.tile_index, cost });
+			}
+		}
+	}
+
+	cluster.dirty = false;
+}
+
+void cluster_graph::add_border_entrances(const QPoint &cluster_pos, const QPoint &neighbor_cluster_pos, std::map<int, std::vector<int>> &entrances) const
+{
+	const QRect cluster_rect = this->get_cluster_rect(cluster_pos);
+	const QPoint offset = neighbor_cluster_pos - cluster_pos;
+
+	//the first tile of the border in this cluster, and the direction in which the border runs
+	QPoint border_start;
+	QPoint border_direction;
+	int border_length = 0;
+
+	if (offset.x() != 0) {
+		border_start = QPoint(offset.x() > 0 ? cluster_rect.right() : cluster_rect.left(), cluster_rect.top());
+		border_direction = QPoint(0, 1);
+		border_length = cluster_rect.height();
+	} else {
+		border_start = QPoint(cluster_rect.left(), offset.y() > 0 ? cluster_rect.bottom() : cluster_rect.top());
+		border_direction = QPoint(1, 0);
+		border_length = cluster_rect.width();
+	}
+
+	const auto add_entrance = [&](const int border_index) {
+		const QPoint tile_pos = border_start + border_direction * border_index;
+		const QPoint neighbor_tile_pos = tile_pos + offset;
+		entrances[point::to_index(tile_pos, this->map_size)].push_back(point::to_index(neighbor_tile_pos, this->map_size));
+	};
+
+	//each run of tiles crossable on both sides of the border is an entrance; long entrances get a transition at each end, and short ones a single transition in their middle
+	static constexpr int long_entrance_length = 6;
+
+	int run_start = -1;
+
+	for (int i = 0; i <= border_length; ++i) {
+		bool crossable = false;
+
+		if (i < border_length) {
+			const QPoint tile_pos = border_start + border_direction * i;
+			crossable = this->is_tile_passable(tile_pos) && this->is_tile_passable(tile_pos + offset);
+		}
+
+		if (crossable) {
+			if (run_start == -1) {
+				run_start = i;
+			}
+			continue;
+		}
+
+		if (run_start == -1) {
+			continue;
+		}
+
+		const int run_end = i - 1;
+
+		if (run_end - run_start + 1 >= long_entrance_length) {
+			add_entrance(run_start);
+			add_entrance(run_end);
+		} else {
+			add_entrance((run_start + run_end) / 2);
+		}
+
+		run_start = -1;
+	}
+}
+
+std::vector<int> cluster_graph::calculate_local_costs(const QRect &rect, const std::vector<QPoint> &sources) const
+{
+	static constexpr std::array<QPoint, 8> offsets = { QPoint(0, -1), QPoint(-1, 0), QPoint(1, 0), QPoint(0, 1), QPoint(-1, -1), QPoint(1, -1), QPoint(-1, 1), QPoint(1, 1) };
+
+	std::vector<int> costs(rect.width() * rect.height(), unreachable_cost);
+
+	//the queue holds pairs of cost and local tile index, so that ties are broken by the tile index, keeping the result deterministic
+	std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+
+	for (const QPoint &source : sources) {
+		const int local_index = point::to_index(source - rect.topLeft(), rect.size());
+		costs[local_index] = 0;
+		queue.emplace(0, local_index);
+	}
+
+	while (!queue.empty()) {
+		const auto [cost, local_index] = queue.top();
+		queue.pop();
+
+		if (cost > costs[local_index]) {
+			continue;
+		}
+
+		const QPoint tile_pos = point::from_index(local_index, rect.size()) + rect.topLeft();
+
+		for (const QPoint &offset : offsets) {
+			const QPoint adjacent_pos = tile_pos + offset;
+
+			if (!rect.contains(adjacent_pos) || !this->is_tile_passable(adjacent_pos)) {
+				continue;
+			}
+
+			const int adjacent_index = point::to_index(adjacent_pos - rect.topLeft(), rect.size());
+			const int adjacent_cost = cost + this->get_tile_cost(adjacent_pos);
+
+			if (adjacent_cost < costs[adjacent_index]) {
+				costs[adjacent_index] = adjacent_cost;
+				queue.emplace(adjacent_cost, adjacent_index);
+			}
+		}
+	}
+
+	return costs;
+}
+
+const cluster_graph::node *cluster_graph::find_node(const int tile_index)
+{
+	const cluster &cluster = this->get_cluster(this->get_cluster_pos(point::from_index(tile_index, this->map_size)));
+
+	const auto find_iterator = std::lower_bound(cluster.nodes.begin(), cluster.nodes.end(), tile_index, [](const node &node, const int tile_index) {
+		return node.tile_index < tile_index;
+	});
+
+	if (find_iterator == cluster.nodes.end() || find_iterator->tile_index != tile_index) {
+		return nullptr;
+	}
+
+	return &*find_iterator;
+}
+
+std::vector<QPoint> cluster_graph::find_path(const QPoint &start_pos, const QRect &goal_rect)
+{
+	const QPoint start_cluster_pos = this->get_cluster_pos(start_pos);
+	const QPoint goal_cluster_pos = this->get_cluster_pos(goal_rect.topLeft());
+
+	if (start_cluster_pos == goal_cluster_pos) {
+		return {};
+	}
+
+	//connect the start position to the nodes of its cluster
+	const QRect start_cluster_rect = this->get_cluster_rect(start_cluster_pos);
+	const std::vector<int> start_costs = this->calculate_local_costs(start_cluster_rect, { start_pos });
+
+	//connect the nodes of the goal's cluster to the goal, using the crossable tiles in or adjacent to the goal rectangle
+	const QRect goal_cluster_rect = this->get_cluster_rect(goal_cluster_pos);
+	std::vector<QPoint> goal_sources;
+	const QRect goal_area = goal_rect.adjusted(-1, -1, 1, 1).intersected(goal_cluster_rect);
+	for (int x = goal_area.left(); x <= goal_area.right(); ++x) {
+		for (int y = goal_area.top(); y <= goal_area.bottom(); ++y) {
+			const QPoint tile_pos(x, y);
+			if (this->is_tile_passable(tile_pos)) {
+				goal_sources.push_back(tile_pos);
+			}
+		}
+	}
+
+	if (goal_sources.empty()) {
+		return {};
+	}
+
+	const std::vector<int> goal_costs = this->calculate_local_costs(goal_cluster_rect, goal_sources);
+
+	//the goal itself is represented by a node with the tile index -1
+	static constexpr int goal_index = -1;
+	static constexpr int no_parent = -2;
+
+	struct search_node final
+	{
+		int cost = unreachable_cost;
+		int parent = no_parent;
+		bool closed = false;
+	};
+
+	std::map<int, search_node> search_nodes;
+
+	//the queue holds the estimated total cost, the cost so far and the tile index of each open node
+	using queue_element = std::tuple<int, int, int>;
+	std::priority_queue<queue_element, std::vector<queue_element>, std::greater<queue_element>> queue;
+
+	const auto open_node = [&](const int tile_index, const int cost, const int parent) {
+		search_node &search_node = search_nodes[tile_index];
+		if (cost >= search_node.cost) {
+			return;
+		}
+
+		search_node.cost = cost;
+		search_node.parent = parent;
+
+		const int estimated_cost = tile_index == goal_index ? cost : cost + get_chebyshev_distance(point::from_index(tile_index, this->map_size), goal_rect);
+		queue.emplace(estimated_cost, cost, tile_index);
+	};
+
+	for (const node &node : this->get_cluster(start_cluster_pos).nodes) {
+		const QPoint local_pos = point::from_index(node.tile_index, this->map_size) - start_cluster_rect.topLeft();
+		const int cost = start_costs[point::to_index(local_pos, start_cluster_rect.size())];
+
+		if (cost != unreachable_cost) {
+			open_node(node.tile_index, cost, no_parent);
+		}
+	}
+
+	bool found = false;
+
+	while (!queue.empty()) {
+		const auto [estimated_cost, cost, tile_index] = queue.top();
+		queue.pop();
+
+		search_node &search_node = search_nodes[tile_index];
+		if (search_node.closed || cost > search_node.cost) {
+			continue;
+		}
+		search_node.closed = true;
+
+		if (tile_index == goal_index) {
+			found = true;
+			break;
+		}
+
+		const QPoint tile_pos = point::from_index(tile_index, this->map_size);
+
+		if (goal_cluster_rect.contains(tile_pos)) {
+			const int goal_cost = goal_costs[point::to_index(tile_pos - goal_cluster_rect.topLeft(), goal_cluster_rect.size())];
+
+			if (goal_cost != unreachable_cost) {
+				open_node(goal_index, cost + goal_cost, tile_index);
+			}
+		}
+
+		const node *node = this->find_node(tile_index);
+		if (node == nullptr) {
+			continue;
+		}
+
+		for (const edge &edge : node->edges) {
+			open_node(edge.target_index, cost + edge.cost, tile_index);
+		}
+	}
+
+	if (!found) {
+		return {};
+	}
+
+	std::vector<QPoint> path;
+
+	for (int tile_index = search_nodes[goal_index].parent; tile_index != no_parent; tile_index = search_nodes[tile_index].parent) {
+		path.push_back(point::from_index(tile_index, this->map_size));
+	}
+
+	std::reverse(path.begin(), path.end());
+
+	return path;
+}
+
+void hierarchical_pathfinder::clear()
+{
+	this->graphs.clear();
+}
+
+void hierarchical_pathfinder::on_tile_changed(const QPoint &tile_pos, const int z)
+{
+	if (z >= static_cast<int>(this->graphs.size())) {
+		return;
+	}
+
+	for (const auto &[movement_mask, graph] : this->graphs[z]) {
+		graph->set_tile_dirty(tile_pos);
+	}
+}
+
+QPoint hierarchical_pathfinder::find_waypoint(const CUnit &unit, const QPoint &goal_pos, const QSize &goal_size, const int max_range, const int z)
+{
+	static const QPoint invalid_point(-1, -1);
+
+	//only single-tile units not bound to rails use the cluster graphs
+	if (unit.Type->get_tile_size() != QSize(1, 1) || unit.Type->BoolFlag[RAIL_INDEX].value) {
+		return invalid_point;
+	}
+
+	if (unit.MapLayer->ID != z) {
+		return invalid_point;
+	}
+
+	//the cluster graphs are built from the real terrain, so using them without knowledge of unseen terrain would route units around obstacles they haven't explored; AI players already rely on the real terrain, as in the goal connectivity check
+	if (!AStarKnowUnseenTerrain && !unit.Player->AiEnabled) {
+		return invalid_point;
+	}
+
+	const QPoint start_pos = unit.tilePos;
+	const QRect goal_rect(goal_pos, QSize(std::max(goal_size.width(), 1), std::max(goal_size.height(), 1)));
+
+	if (get_chebyshev_distance(start_pos, goal_rect) < hierarchical_pathfinder::min_distance + max_range) {
+		return invalid_point;
+	}
+
+	cluster_graph *graph = this->get_graph(z, unit.Type->MovementMask);
+
+	const std::vector<QPoint> path = graph->find_path(start_pos, goal_rect);
+
+	//use the farthest node along the path which is still near enough to the unit
+	QPoint waypoint = invalid_point;
+
+	for (const QPoint &node_pos : path) {
+		if (node_pos == start_pos) {
+			continue;
+		}
+
+		if (waypoint != invalid_point && point::distance_to(start_pos, node_pos) > hierarchical_pathfinder::max_waypoint_distance) {
+			break;
+		}
+
+		waypoint = node_pos;
+	}
+
+	return waypoint;
+}
+
+cluster_graph *hierarchical_pathfinder::get_graph(const int z, const tile_flag movement_mask)
+{
+	if (z >= static_cast<int>(this->graphs.size())) {
+		this->graphs.resize(CMap::get()->MapLayers.size());
+	}
+
+	std::unique_ptr<cluster_graph> &graph = this->graphs[z][movement_mask];
+
+	if (graph == nullptr) {
+		graph = std::make_unique<cluster_graph>(z, movement_mask);
+	}
+
+	return graph.get();
+}
+
+}
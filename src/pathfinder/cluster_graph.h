@@ -0,0 +1,131 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#pragma once
+
+#include "util/singleton.h"
+
+class CUnit;
+
+namespace wyrmgus {
+
+enum class tile_flag : uint32_t;
+
+//an abstract graph over the fixed-size clusters of a map layer, for a given movement mask
+//the nodes of the graph are the entrance tiles between adjacent clusters, and its edges are the costs of moving between entrances; the graph is used to plan long paths without searching the whole map
+class cluster_graph final
+{
+public:
+	static constexpr int cluster_size = 16;
+
+	struct edge final
+	{
+		int target_index = 0; //the tile index of the target node
+		int cost = 0;
+	};
+
+	struct node final
+	{
+		int tile_index = 0;
+		std::vector<edge> edges;
+	};
+
+	struct cluster final
+	{
+		std::vector<node> nodes; //sorted by tile index
+		bool dirty = true;
+	};
+
+	explicit cluster_graph(const int z, const tile_flag movement_mask);
+
+	//get whether a tile can be crossed, ignoring units which aren't buildings, as they can move away
+	bool is_tile_passable(const QPoint &tile_pos) const;
+
+	int get_tile_cost(const QPoint &tile_pos) const;
+
+	QPoint get_cluster_pos(const QPoint &tile_pos) const
+	{
+		return QPoint(tile_pos.x() / cluster_graph::cluster_size, tile_pos.y() / cluster_graph::cluster_size);
+	}
+
+	bool is_cluster_pos_valid(const QPoint &cluster_pos) const
+	{
+		return cluster_pos.x() >= 0 && cluster_pos.y() >= 0 && cluster_pos.x() < this->cluster_grid_size.width() && cluster_pos.y() < this->cluster_grid_size.height();
+	}
+
+	QRect get_cluster_rect(const QPoint &cluster_pos) const;
+
+	//get a cluster, recalculating its nodes and edges first if it has been marked as dirty
+	const cluster &get_cluster(const QPoint &cluster_pos);
+
+	//mark the clusters whose entrances or edges may be affected by a change to the given tile as needing recalculation
+	void set_tile_dirty(const QPoint &tile_pos);
+
+	//find a path through the graph's nodes from the start position to the goal rectangle
+	//returns the tile positions of the nodes along the path, or an empty vector if no path was found, or if the start and the goal are in the same cluster
+	std::vector<QPoint> find_path(const QPoint &start_pos, const QRect &goal_rect);
+
+private:
+	void calculate_cluster(const QPoint &cluster_pos);
+	void add_border_entrances(const QPoint &cluster_pos, const QPoint &neighbor_cluster_pos, std::map<int, std::vector<int>> &entrances) const;
+
+	//calculate the costs of reaching each tile of a rectangle from the given sources, without leaving the rectangle
+	std::vector<int> calculate_local_costs(const QRect &rect, const std::vector<QPoint> &sources) const;
+
+	const node *find_node(const int tile_index);
+
+private:
+	int z = 0;
+	tile_flag movement_mask;
+	QSize map_size;
+	QSize cluster_grid_size;
+	std::vector<cluster> clusters;
+};
+
+//keeps the cluster graphs of each map layer and movement mask, and uses them to find waypoints for long paths
+class hierarchical_pathfinder final : public singleton<hierarchical_pathfinder>
+{
+public:
+	//the minimum distance to the goal for hierarchical pathfinding to be used
+	static constexpr int min_distance = cluster_graph::cluster_size * 2;
+
+	//the maximum distance from the unit of the waypoint given for a path
+	static constexpr int max_waypoint_distance = cluster_graph::cluster_size * 2;
+
+	void clear();
+	void on_tile_changed(const QPoint &tile_pos, const int z);
+
+	//get the next waypoint to which a unit should move on its way to a distant goal, or an invalid point if hierarchical pathfinding can't be used
+	QPoint find_waypoint(const CUnit &unit, const QPoint &goal_pos, const QSize &goal_size, const int max_range, const int z);
+
+private:
+	cluster_graph *get_graph(const int z, const tile_flag movement_mask);
+
+private:
+	std::vector<std::map<tile_flag, std::unique_ptr<cluster_graph>>> graphs; //cluster graphs per map layer and movement mask
+};
+
+}
@@ -0,0 +1,253 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#include "stratagus.h"
+
+#include "pathfinder/connectivity.h"
+
+#include "map/map.h"
+#include "map/map_layer.h"
+#include "map/tile.h"
+#include "map/tile_flag.h"
+#include "pathfinder.h"
+#include "util/point_util.h"
+
+namespace wyrmgus {
+
+connectivity_map::connectivity_map(const int z, const tile_flag movement_mask)
+	: z(z), movement_mask(movement_mask)
+{
+	this->map_size = CMap::get()->MapLayers[z]->get_size();
+}
+
+int connectivity_map::get_component(const QPoint &tile_pos)
+{
+	if (this->dirty) {
+		this->calculate();
+	}
+
+	const int component = this->tile_components[point::to_index(tile_pos, this->map_size)];
+
+	if (component == -1) {
+		return -1;
+	}
+
+	return this->find_root(component);
+}
+
+void connectivity_map::on_tile_changed(const QPoint &tile_pos)
+{
+	if (this->dirty) {
+		//will be recalculated anyway
+		return;
+	}
+
+	int &component = this->tile_components[point::to_index(tile_pos, this->map_size)];
+	const bool passable = this->is_tile_passable(tile_pos);
+
+	if (passable == (component != -1)) {
+		return;
+	}
+
+	if (!passable) {
+		component = -1;
+
+		++this->blocked_tile_count;
+		if (this->blocked_tile_count >= connectivity_map::max_blocked_tiles) {
+			this->dirty = true;
+		}
+
+		return;
+	}
+
+	//the tile has become passable, so merge the components adjacent to it
+	for (size_t direction = 0; direction < 8; ++direction) {
+		const QPoint adjacent_pos(tile_pos.x() + Heading2X[direction], tile_pos.y() + Heading2Y[direction]);
+
+		if (adjacent_pos.x() < 0 || adjacent_pos.y() < 0 || adjacent_pos.x() >= this->map_size.width() || adjacent_pos.y() >= this->map_size.height()) {
+			continue;
+		}
+
+		const int adjacent_component = this->tile_components[point::to_index(adjacent_pos, this->map_size)];
+		if (adjacent_component == -1) {
+			continue;
+		}
+
+		const int adjacent_root = this->find_root(adjacent_component);
+
+		if (component == -1) {
+			component = adjacent_root;
+			continue;
+		}
+
+		const int root = this->find_root(component);
+		if (root != adjacent_root) {
+			//keep the lower index as the root, so that the result doesn't depend on the order of the merges
+			this->component_parents[std::max(root, adjacent_root)] = std::min(root, adjacent_root);
+		}
+	}
+
+	if (component == -1) {
+		//an isolated tile, so it has a component of its own
+		component = static_cast<int>(this->component_parents.size());
+		this->component_parents.push_back(component);
+	}
+}
+
+bool connectivity_map::is_tile_passable(const QPoint &tile_pos) const
+{
+	return CMap::get()->Field(tile_pos, this->z)->is_passable_ignoring_mobile_units(this->movement_mask);
+}
+
+void connectivity_map::calculate()
+{
+	const int tile_count = this->map_size.width() * this->map_size.height();
+	this->tile_components.assign(tile_count, -1);
+	this->component_parents.clear();
+
+	std::vector<bool> visited(tile_count, false);
+	std::vector<int> stack;
+
+	for (int tile_index = 0; tile_index < tile_count; ++tile_index) {
+		if (visited[tile_index]) {
+			continue;
+		}
+
+		visited[tile_index] = true;
+
+		if (!this->is_tile_passable(point::from_index(tile_index, this->map_size))) {
+			continue;
+		}
+
+		const int component = static_cast<int>(this->component_parents.size());
+		this->component_parents.push_back(component);
+
+		stack.push_back(tile_index);
+
+		while (!stack.empty()) {
+			const int current_index = stack.back();
+			stack.pop_back();
+
+			this->tile_components[current_index] = component;
+
+			const QPoint tile_pos = point::from_index(current_index, this->map_size);
+
+			for (size_t direction = 0; direction < 8; ++direction) {
+				const QPoint adjacent_pos(tile_pos.x() + Heading2X[direction], tile_pos.y() + Heading2Y[direction]);
+
+				if (adjacent_pos.x() < 0 || adjacent_pos.y() < 0 || adjacent_pos.x() >= this->map_size.width() || adjacent_pos.y() >= this->map_size.height()) {
+					continue;
+				}
+
+				const int adjacent_index = point::to_index(adjacent_pos, this->map_size);
+
+				if (visited[adjacent_index]) {
+					continue;
+				}
+
+				if (!this->is_tile_passable(adjacent_pos)) {
+					continue;
+				}
+
+				visited[adjacent_index] = true;
+				stack.push_back(adjacent_index);
+			}
+		}
+	}
+
+	this->blocked_tile_count = 0;
+	this->dirty = false;
+}
+
+int connectivity_map::find_root(int component)
+{
+	while (this->component_parents[component] != component) {
+		//path halving
+		this->component_parents[component] = this->component_parents[this->component_parents[component]];
+		component = this->component_parents[component];
+	}
+
+	return component;
+}
+
+void connectivity::clear()
+{
+	this->maps.clear();
+}
+
+void connectivity::on_tile_changed(const QPoint &tile_pos, const int z)
+{
+	if (z >= static_cast<int>(this->maps.size())) {
+		return;
+	}
+
+	for (const auto &[movement_mask, map] : this->maps[z]) {
+		map->on_tile_changed(tile_pos);
+	}
+}
+
+bool connectivity::can_reach(const QPoint &start_pos, const QRect &goal_rect, const tile_flag movement_mask, const int z)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	connectivity_map *map = this->get_map(z, movement_mask);
+
+	const int start_component = map->get_component(start_pos);
+	if (start_component == -1) {
+		//the start tile is blocked, e.g. because of a building placed over the unit, so we can't tell
+		return true;
+	}
+
+	const QRect map_rect(QPoint(0, 0), CMap::get()->MapLayers[z]->get_size());
+	const QRect checked_rect = goal_rect.intersected(map_rect);
+
+	for (int y = checked_rect.top(); y <= checked_rect.bottom(); ++y) {
+		for (int x = checked_rect.left(); x <= checked_rect.right(); ++x) {
+			if (map->get_component(QPoint(x, y)) == start_component) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+connectivity_map *connectivity::get_map(const int z, const tile_flag movement_mask)
+{
+	if (z >= static_cast<int>(this->maps.size())) {
+		this->maps.resize(CMap::get()->MapLayers.size());
+	}
+
+	std::unique_ptr<connectivity_map> &map = this->maps[z][movement_mask];
+
+	if (map == nullptr) {
+		map = std::make_unique<connectivity_map>(z, movement_mask);
+	}
+
+	return map.get();
+}
+
+}
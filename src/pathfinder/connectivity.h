@@ -0,0 +1,83 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#pragma once
+
+#include "util/singleton.h"
+
+namespace wyrmgus {
+
+enum class tile_flag : uint32_t;
+
+//the connected components of the tiles of a map layer which can be crossed with a given movement mask
+//tiles becoming passable merge components incrementally; tiles becoming impassable may split a component, which is only done when the components are next recalculated, so until then the components may be larger than they really are, but never smaller
+class connectivity_map final
+{
+public:
+	//the number of tiles which can become impassable before the components are recalculated
+	static constexpr int max_blocked_tiles = 32;
+
+	explicit connectivity_map(const int z, const tile_flag movement_mask);
+
+	//get the component of a tile, or -1 if the tile is impassable
+	int get_component(const QPoint &tile_pos);
+
+	void on_tile_changed(const QPoint &tile_pos);
+
+private:
+	bool is_tile_passable(const QPoint &tile_pos) const;
+	void calculate();
+	int find_root(int component);
+
+private:
+	int z = 0;
+	tile_flag movement_mask;
+	QSize map_size;
+	std::vector<int> tile_components;
+	std::vector<int> component_parents; //the parent of each component in its union-find tree
+	int blocked_tile_count = 0;
+	bool dirty = true;
+};
+
+class connectivity final : public singleton<connectivity>
+{
+public:
+	void clear();
+	void on_tile_changed(const QPoint &tile_pos, const int z);
+
+	//get whether any tile in the goal rectangle may be reached from the start position with the movement mask
+	//returns false only if the goal certainly can't be reached, i.e. if the start tile is passable and no tile of the goal rectangle is in its component
+	bool can_reach(const QPoint &start_pos, const QRect &goal_rect, const tile_flag movement_mask, const int z);
+
+private:
+	connectivity_map *get_map(const int z, const tile_flag movement_mask);
+
+private:
+	std::vector<std::map<tile_flag, std::unique_ptr<connectivity_map>>> maps; //connectivity maps per map layer and movement mask
+	std::mutex mutex; //the maps are created and recalculated lazily, so reachability checks made in parallel must be serialized
+};
+
+}
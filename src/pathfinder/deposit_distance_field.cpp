@@ -0,0 +1,293 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#include "stratagus.h"
+
+#include "pathfinder/deposit_distance_field.h"
+
+#include "map/map.h"
+#include "map/map_layer.h"
+#include "map/tile.h"
+#include "map/tile_flag.h"
+#include "pathfinder.h"
+#include "unit/unit.h"
+#include "util/point_util.h"
+
+namespace wyrmgus {
+
+deposit_distance_field::deposit_distance_field(const deposit_distance_field_key &key) : key(key)
+{
+	this->map_size = CMap::get()->MapLayers[key.z]->get_size();
+}
+
+void deposit_distance_field::set_deposits(const std::vector<CUnit *> &deposits)
+{
+	std::vector<deposit_info> new_deposits;
+	new_deposits.reserve(deposits.size());
+
+	for (CUnit *deposit : deposits) {
+		new_deposits.push_back(deposit_info{ deposit, deposit->get_tile_rect() });
+	}
+
+	if (new_deposits == this->deposits) {
+		return;
+	}
+
+	if (this->dirty) {
+		this->deposits = std::move(new_deposits);
+		return;
+	}
+
+	//if deposits have only been added, distances can only have become shorter, so they are propagated from the new deposits alone
+	std::vector<deposit_info> added_deposits;
+
+	for (const deposit_info &deposit : new_deposits) {
+		if (std::find(this->deposits.begin(), this->deposits.end(), deposit) == this->deposits.end()) {
+			added_deposits.push_back(deposit);
+		}
+	}
+
+	if (new_deposits.size() != this->deposits.size() + added_deposits.size()) {
+		//a deposit has been removed
+		this->deposits = std::move(new_deposits);
+		this->dirty = true;
+		return;
+	}
+
+	std::queue<int> queue;
+
+	for (const deposit_info &deposit : added_deposits) {
+		this->deposits.push_back(deposit);
+		this->seed_deposit(static_cast<int>(this->deposits.size()) - 1, queue);
+	}
+
+	this->propagate(queue);
+}
+
+CUnit *deposit_distance_field::get_nearest_deposit(const CUnit &unit)
+{
+	if (this->dirty) {
+		this->calculate();
+	}
+
+	//the unit may be inside a building, in which case it would leave it from a tile adjacent to it
+	const CUnit *first_container = unit.GetFirstContainer();
+	const QRect rect = first_container->get_tile_rect().adjusted(-1, -1, 1, 1).intersected(QRect(QPoint(0, 0), this->map_size));
+
+	int best_distance = deposit_distance_field::unreached;
+	int best_deposit_index = -1;
+
+	for (int y = rect.top(); y <= rect.bottom(); ++y) {
+		for (int x = rect.left(); x <= rect.right(); ++x) {
+			const int tile_index = point::to_index(x, y, this->map_size);
+			const int distance = this->distances[tile_index];
+
+			if (distance == deposit_distance_field::unreached) {
+				continue;
+			}
+
+			if (best_distance == deposit_distance_field::unreached || distance < best_distance) {
+				best_distance = distance;
+				best_deposit_index = this->nearest_deposits[tile_index];
+			}
+		}
+	}
+
+	if (best_deposit_index == -1) {
+		return nullptr;
+	}
+
+	return this->deposits[best_deposit_index].unit;
+}
+
+void deposit_distance_field::on_tile_changed(const QPoint &tile_pos)
+{
+	if (this->dirty) {
+		//will be recalculated anyway
+		return;
+	}
+
+	const int tile_index = point::to_index(tile_pos, this->map_size);
+
+	if (!this->is_tile_passable(tile_pos)) {
+		if (this->distances[tile_index] != deposit_distance_field::unreached) {
+			//paths through the tile may have become longer, which can't be propagated
+			this->dirty = true;
+		}
+
+		return;
+	}
+
+	//the tile may have become passable, so it may now be reached, and paths through it may be shorter
+	int best_distance = this->distances[tile_index];
+	int best_deposit_index = this->nearest_deposits[tile_index];
+
+	for (size_t i = 0; i < this->deposits.size(); ++i) {
+		if (this->deposits[i].rect.adjusted(-1, -1, 1, 1).contains(tile_pos)) {
+			best_distance = 0;
+			best_deposit_index = static_cast<int>(i);
+			break;
+		}
+	}
+
+	if (best_distance != 0) {
+		for (size_t direction = 0; direction < 8; ++direction) {
+			const QPoint adjacent_pos(tile_pos.x() + Heading2X[direction], tile_pos.y() + Heading2Y[direction]);
+
+			if (adjacent_pos.x() < 0 || adjacent_pos.y() < 0 || adjacent_pos.x() >= this->map_size.width() || adjacent_pos.y() >= this->map_size.height()) {
+				continue;
+			}
+
+			const int adjacent_index = point::to_index(adjacent_pos, this->map_size);
+			const int adjacent_distance = this->distances[adjacent_index];
+
+			if (adjacent_distance == deposit_distance_field::unreached) {
+				continue;
+			}
+
+			if (best_distance == deposit_distance_field::unreached || adjacent_distance + 1 < best_distance) {
+				best_distance = adjacent_distance + 1;
+				best_deposit_index = this->nearest_deposits[adjacent_index];
+			}
+		}
+	}
+
+	if (best_distance == this->distances[tile_index]) {
+		return;
+	}
+
+	this->distances[tile_index] = best_distance;
+	this->nearest_deposits[tile_index] = best_deposit_index;
+
+	std::queue<int> queue;
+	queue.push(tile_index);
+	this->propagate(queue);
+}
+
+bool deposit_distance_field::is_tile_passable(const QPoint &tile_pos) const
+{
+	return CMap::get()->Field(tile_pos, this->key.z)->is_passable_ignoring_mobile_units(this->key.movement_mask);
+}
+
+void deposit_distance_field::calculate()
+{
+	const int tile_count = this->map_size.width() * this->map_size.height();
+	this->distances.assign(tile_count, deposit_distance_field::unreached);
+	this->nearest_deposits.assign(tile_count, -1);
+
+	std::queue<int> queue;
+
+	for (size_t i = 0; i < this->deposits.size(); ++i) {
+		this->seed_deposit(static_cast<int>(i), queue);
+	}
+
+	this->propagate(queue);
+
+	this->dirty = false;
+}
+
+void deposit_distance_field::seed_deposit(const int deposit_index, std::queue<int> &queue)
+{
+	//the deposit is reached from the tiles adjacent to it
+	const QRect rect = this->deposits[deposit_index].rect.adjusted(-1, -1, 1, 1).intersected(QRect(QPoint(0, 0), this->map_size));
+
+	for (int y = rect.top(); y <= rect.bottom(); ++y) {
+		for (int x = rect.left(); x <= rect.right(); ++x) {
+			const int tile_index = point::to_index(x, y, this->map_size);
+
+			if (this->distances[tile_index] == 0 || !this->is_tile_passable(QPoint(x, y))) {
+				continue;
+			}
+
+			this->distances[tile_index] = 0;
+			this->nearest_deposits[tile_index] = deposit_index;
+			queue.push(tile_index);
+		}
+	}
+}
+
+void deposit_distance_field::propagate(std::queue<int> &queue)
+{
+	while (!queue.empty()) {
+		const int tile_index = queue.front();
+		queue.pop();
+
+		const QPoint tile_pos = point::from_index(tile_index, this->map_size);
+		const int adjacent_distance = this->distances[tile_index] + 1;
+
+		for (size_t direction = 0; direction < 8; ++direction) {
+			const QPoint adjacent_pos(tile_pos.x() + Heading2X[direction], tile_pos.y() + Heading2Y[direction]);
+
+			if (adjacent_pos.x() < 0 || adjacent_pos.y() < 0 || adjacent_pos.x() >= this->map_size.width() || adjacent_pos.y() >= this->map_size.height()) {
+				continue;
+			}
+
+			const int adjacent_index = point::to_index(adjacent_pos, this->map_size);
+
+			if (this->distances[adjacent_index] != deposit_distance_field::unreached && this->distances[adjacent_index] <= adjacent_distance) {
+				continue;
+			}
+
+			if (!this->is_tile_passable(adjacent_pos)) {
+				continue;
+			}
+
+			this->distances[adjacent_index] = adjacent_distance;
+			this->nearest_deposits[adjacent_index] = this->nearest_deposits[tile_index];
+			queue.push(adjacent_index);
+		}
+	}
+}
+
+deposit_distance_field *deposit_distance_field_cache::get_field(const deposit_distance_field_key &key, const std::vector<CUnit *> &deposits)
+{
+	std::unique_ptr<deposit_distance_field> &field = this->fields[key];
+
+	if (field == nullptr) {
+		field = std::make_unique<deposit_distance_field>(key);
+	}
+
+	field->set_deposits(deposits);
+
+	return field.get();
+}
+
+void deposit_distance_field_cache::clear()
+{
+	this->fields.clear();
+}
+
+void deposit_distance_field_cache::on_tile_changed(const QPoint &tile_pos, const int z)
+{
+	for (const auto &[key, field] : this->fields) {
+		if (key.z == z) {
+			field->on_tile_changed(tile_pos);
+		}
+	}
+}
+
+}
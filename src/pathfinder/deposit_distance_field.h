@@ -0,0 +1,108 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#pragma once
+
+#include "util/singleton.h"
+
+class CUnit;
+
+namespace wyrmgus {
+
+enum class tile_flag : uint32_t;
+
+//the parameters which determine a deposit distance field
+struct deposit_distance_field_key final
+{
+	bool operator <(const deposit_distance_field_key &other) const
+	{
+		return std::tie(this->player_index, this->resource_index, this->z, this->movement_mask) < std::tie(other.player_index, other.resource_index, other.z, other.movement_mask);
+	}
+
+	int player_index = -1;
+	int resource_index = -1;
+	int z = 0;
+	tile_flag movement_mask;
+};
+
+//a field giving, for each tile of a map layer, the distance to the nearest deposit to which a player's workers can return a resource, and which deposit that is
+//it is calculated with a single breadth-first search from all the deposits, so that workers returning goods don't need a path search per deposit
+class deposit_distance_field final
+{
+public:
+	static constexpr int unreached = -1;
+
+	explicit deposit_distance_field(const deposit_distance_field_key &key);
+
+	//set the deposits from which the distances are measured; added deposits only propagate their distances over the tiles which become closer to them, while removed ones require the field to be recalculated
+	void set_deposits(const std::vector<CUnit *> &deposits);
+
+	//get the deposit nearest to a unit, or null if no deposit can be reached from it
+	CUnit *get_nearest_deposit(const CUnit &unit);
+
+	void on_tile_changed(const QPoint &tile_pos);
+
+private:
+	struct deposit_info final
+	{
+		bool operator ==(const deposit_info &other) const
+		{
+			return this->unit == other.unit && this->rect == other.rect;
+		}
+
+		CUnit *unit = nullptr;
+		QRect rect;
+	};
+
+	bool is_tile_passable(const QPoint &tile_pos) const;
+	void calculate();
+	void seed_deposit(const int deposit_index, std::queue<int> &queue);
+	void propagate(std::queue<int> &queue);
+
+private:
+	deposit_distance_field_key key;
+	QSize map_size;
+	std::vector<deposit_info> deposits;
+	std::vector<int> distances;
+	std::vector<int> nearest_deposits; //the index of the nearest deposit for each tile
+	bool dirty = true;
+};
+
+class deposit_distance_field_cache final : public singleton<deposit_distance_field_cache>
+{
+public:
+	//get the deposit distance field for a key, with its deposits updated
+	deposit_distance_field *get_field(const deposit_distance_field_key &key, const std::vector<CUnit *> &deposits);
+
+	void clear();
+	void on_tile_changed(const QPoint &tile_pos, const int z);
+
+private:
+	std::map<deposit_distance_field_key, std::unique_ptr<deposit_distance_field>> fields;
+};
+
+}
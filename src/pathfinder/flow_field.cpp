@@ -0,0 +1,339 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#include "stratagus.h"
+
+#include "pathfinder/flow_field.h"
+
+#include "map/map.h"
+#include "map/map_layer.h"
+#include "map/tile.h"
+#include "map/tile_flag.h"
+#include "pathfinder.h"
+#include "player.h"
+#include "unit/unit.h"
+#include "unit/unit_type.h"
+#include "unit/unit_type_type.h"
+#include "util/point_util.h"
+#include "util/util.h"
+
+namespace wyrmgus {
+
+flow_field::flow_field(const flow_field_key &key) : key(key)
+{
+	this->map_size = CMap::get()->MapLayers[key.z]->get_size();
+	this->calculate();
+}
+
+char flow_field::get_direction(const QPoint &tile_pos) const
+{
+	return this->directions[point::to_index(tile_pos, this->map_size)];
+}
+
+int flow_field::get_cost(const QPoint &tile_pos) const
+{
+	return this->costs[point::to_index(tile_pos, this->map_size)];
+}
+
+bool flow_field::is_goal_tile(const QPoint &tile_pos) const
+{
+	//use the same range check as the A* goal marking, i.e. the tile must be within a circle of the max range around the goal rectangle
+	const int dx = std::max({ this->key.goal_x - tile_pos.x(), 0, tile_pos.x() - (this->key.goal_x + this->key.goal_width - 1) });
+	const int dy = std::max({ this->key.goal_y - tile_pos.y(), 0, tile_pos.y() - (this->key.goal_y + this->key.goal_height - 1) });
+
+	return square(dx) + square(dy) < square(this->key.max_range + 1);
+}
+
+bool flow_field::is_tile_passable(const QPoint &tile_pos) const
+{
+	return CMap::get()->Field(tile_pos, this->key.z)->is_passable_ignoring_mobile_units(this->key.movement_mask);
+}
+
+int flow_field::get_tile_cost(const QPoint &tile_pos) const
+{
+	const tile *tile = CMap::get()->Field(tile_pos, this->key.z);
+
+	//add one for walking, as A* does
+	int cost = 1;
+
+	if (this->key.flying) {
+		cost += DefaultTileMovementCost;
+	} else {
+		cost += tile->get_movement_cost();
+	}
+
+	//no cost is added for unexplored tiles, as only players which know the terrain use flow fields, and fields aren't updated when tiles are explored
+
+	return cost;
+}
+
+void flow_field::calculate()
+{
+	const int tile_count = this->map_size.width() * this->map_size.height();
+	this->costs.assign(tile_count, -1);
+	this->directions.assign(tile_count, flow_field::no_direction);
+	this->tile_costs.assign(tile_count, -1);
+
+	//the queue holds pairs of cost and tile index, so that ties are broken by the tile index, keeping the result deterministic
+	tile_queue queue;
+
+	const QRect goal_area = QRect(this->key.goal_x, this->key.goal_y, this->key.goal_width, this->key.goal_height).adjusted(-this->key.max_range, -this->key.max_range, this->key.max_range, this->key.max_range).intersected(QRect(QPoint(0, 0), this->map_size));
+
+	for (int y = goal_area.top(); y <= goal_area.bottom(); ++y) {
+		for (int x = goal_area.left(); x <= goal_area.right(); ++x) {
+			const QPoint tile_pos(x, y);
+
+			if (!this->is_goal_tile(tile_pos) || !this->is_tile_passable(tile_pos)) {
+				continue;
+			}
+
+			const int tile_index = point::to_index(tile_pos, this->map_size);
+			this->costs[tile_index] = 0;
+			this->directions[tile_index] = flow_field::goal_direction;
+			queue.emplace(0, tile_index);
+		}
+	}
+
+	this->propagate(queue);
+}
+
+void flow_field::propagate(tile_queue &queue)
+{
+	//search backwards from the goal: the cost of moving from a tile to an adjacent one is the cost of entering the latter
+	while (!queue.empty()) {
+		const auto [cost, tile_index] = queue.top();
+		queue.pop();
+
+		if (cost > this->costs[tile_index]) {
+			continue;
+		}
+
+		const QPoint tile_pos = point::from_index(tile_index, this->map_size);
+		const int step_cost = this->get_tile_cost(tile_pos);
+		this->tile_costs[tile_index] = step_cost;
+
+		for (size_t direction = 0; direction < 8; ++direction) {
+			//the tile from which a unit would move in the direction to reach this one
+			const QPoint adjacent_pos(tile_pos.x() - Heading2X[direction], tile_pos.y() - Heading2Y[direction]);
+
+			if (adjacent_pos.x() < 0 || adjacent_pos.y() < 0 || adjacent_pos.x() >= this->map_size.width() || adjacent_pos.y() >= this->map_size.height()) {
+				continue;
+			}
+
+			if (!this->is_tile_passable(adjacent_pos)) {
+				continue;
+			}
+
+			const int adjacent_index = point::to_index(adjacent_pos, this->map_size);
+			const int adjacent_cost = cost + step_cost;
+
+			if (this->costs[adjacent_index] == -1 || adjacent_cost < this->costs[adjacent_index]) {
+				this->costs[adjacent_index] = adjacent_cost;
+				this->directions[adjacent_index] = static_cast<char>(direction);
+				queue.emplace(adjacent_cost, adjacent_index);
+			}
+		}
+	}
+}
+
+bool flow_field::on_tile_changed(const QPoint &tile_pos)
+{
+	const int tile_index = point::to_index(tile_pos, this->map_size);
+
+	if (!this->is_tile_passable(tile_pos)) {
+		//only a blocked tile which units following the field could pass through requires the field to be recalculated
+		return this->costs[tile_index] == -1;
+	}
+
+	const int old_tile_cost = this->tile_costs[tile_index];
+	if (old_tile_cost != -1 && this->get_tile_cost(tile_pos) > old_tile_cost) {
+		//entering the tile has become more expensive, so the costs of the tiles reaching the goal through it are too low, and the best routes may now go elsewhere
+		return false;
+	}
+
+	//the tile has become passable, or has been made no more expensive to enter, which can only lower costs, so propagate the improvements from it as the search would have
+	if (this->is_goal_tile(tile_pos)) {
+		this->costs[tile_index] = 0;
+		this->directions[tile_index] = flow_field::goal_direction;
+	} else {
+		for (size_t direction = 0; direction < 8; ++direction) {
+			//the tile which a unit would reach by moving in the direction from this one
+			const QPoint adjacent_pos(tile_pos.x() + Heading2X[direction], tile_pos.y() + Heading2Y[direction]);
+
+			if (adjacent_pos.x() < 0 || adjacent_pos.y() < 0 || adjacent_pos.x() >= this->map_size.width() || adjacent_pos.y() >= this->map_size.height()) {
+				continue;
+			}
+
+			const int adjacent_index = point::to_index(adjacent_pos, this->map_size);
+			const int adjacent_cost = this->costs[adjacent_index];
+			if (adjacent_cost == -1) {
+				continue;
+			}
+
+			//use the cost of entering the adjacent tile which the field's costs were calculated with
+			const int cost = adjacent_cost + this->tile_costs[adjacent_index];
+			if (this->costs[tile_index] == -1 || cost < this->costs[tile_index]) {
+				this->costs[tile_index] = cost;
+				this->directions[tile_index] = static_cast<char>(direction);
+			}
+		}
+	}
+
+	if (this->costs[tile_index] == -1) {
+		//still not connected to the goal
+		return true;
+	}
+
+	tile_queue queue;
+	queue.emplace(this->costs[tile_index], tile_index);
+	this->propagate(queue);
+
+	return true;
+}
+
+bool flow_field_cache::get_key(const CUnit &unit, const QPoint &goal_pos, const QSize &goal_size, const int min_range, const int max_range, const int z, flow_field_key &key)
+{
+	//only single-tile units not bound to rails, moving to a goal without a minimum range, use flow fields
+	if (unit.Type->get_tile_size() != QSize(1, 1) || unit.Type->BoolFlag[RAIL_INDEX].value || min_range > 0) {
+		return false;
+	}
+
+	if (unit.MapLayer == nullptr || unit.MapLayer->ID != z) {
+		return false;
+	}
+
+	//flow fields are built from the real terrain, so players without knowledge of unseen terrain can't use them, as with the hierarchical waypoints
+	if (!AStarKnowUnseenTerrain && !unit.Player->AiEnabled) {
+		return false;
+	}
+
+	const QPoint unit_pos = unit.tilePos;
+	const QRect goal_rect(goal_pos, QSize(std::max(goal_size.width(), 1), std::max(goal_size.height(), 1)));
+	const int dx = std::max({ goal_rect.left() - unit_pos.x(), 0, unit_pos.x() - goal_rect.right() });
+	const int dy = std::max({ goal_rect.top() - unit_pos.y(), 0, unit_pos.y() - goal_rect.bottom() });
+
+	if (std::max(dx, dy) < flow_field_cache::min_distance + max_range) {
+		return false;
+	}
+
+	key.z = z;
+	key.movement_mask = unit.Type->MovementMask;
+
+	switch (unit.Type->UnitType) {
+		case UnitTypeType::Fly:
+		case UnitTypeType::FlyLow:
+		case UnitTypeType::Space:
+			key.flying = true;
+			break;
+		default:
+			key.flying = false;
+			break;
+	}
+
+	key.player_index = unit.Player->get_index();
+	key.goal_x = goal_rect.x();
+	key.goal_y = goal_rect.y();
+	key.goal_width = goal_rect.width();
+	key.goal_height = goal_rect.height();
+	key.max_range = max_range;
+
+	return true;
+}
+
+std::shared_ptr<flow_field> flow_field_cache::request(const flow_field_key &key, const bool force)
+{
+	const auto find_iterator = this->flow_fields.find(key);
+	if (find_iterator != this->flow_fields.end()) {
+		std::shared_ptr<flow_field> flow_field = find_iterator->second.lock();
+
+		if (flow_field != nullptr) {
+			return flow_field;
+		}
+
+		//no unit uses the flow field anymore
+		this->flow_fields.erase(find_iterator);
+	}
+
+	if (!force) {
+		if (this->request_cycle != GameCycle) {
+			this->request_counts.clear();
+			this->request_cycle = GameCycle;
+		}
+
+		int &request_count = this->request_counts[key];
+		++request_count;
+
+		if (request_count < flow_field_cache::min_group_size) {
+			return nullptr;
+		}
+
+		this->request_counts.erase(key);
+	}
+
+	auto flow_field = std::make_shared<wyrmgus::flow_field>(key);
+	this->flow_fields[key] = flow_field;
+	return flow_field;
+}
+
+void flow_field_cache::clear()
+{
+	for (const auto &[key, weak_flow_field] : this->flow_fields) {
+		const std::shared_ptr<flow_field> flow_field = weak_flow_field.lock();
+
+		if (flow_field != nullptr) {
+			flow_field->set_invalid();
+		}
+	}
+
+	this->flow_fields.clear();
+	this->request_counts.clear();
+}
+
+void flow_field_cache::on_tile_changed(const QPoint &tile_pos, const int z)
+{
+	//update the flow fields of the map layer, invalidating those which can't be updated locally, so that units using them request new ones on their next path calculation
+	for (auto iterator = this->flow_fields.begin(); iterator != this->flow_fields.end();) {
+		if (iterator->first.z != z) {
+			++iterator;
+			continue;
+		}
+
+		const std::shared_ptr<flow_field> flow_field = iterator->second.lock();
+
+		if (flow_field != nullptr && flow_field->on_tile_changed(tile_pos)) {
+			++iterator;
+			continue;
+		}
+
+		if (flow_field != nullptr) {
+			flow_field->set_invalid();
+		}
+
+		iterator = this->flow_fields.erase(iterator);
+	}
+}
+
+}
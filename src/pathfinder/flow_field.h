@@ -0,0 +1,138 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#pragma once
+
+#include "util/singleton.h"
+
+class CUnit;
+
+namespace wyrmgus {
+
+enum class tile_flag : uint32_t;
+
+//the parameters which determine a flow field; units whose paths have the same key can share a flow field
+struct flow_field_key final
+{
+	bool operator <(const flow_field_key &other) const
+	{
+		return std::tie(this->z, this->movement_mask, this->flying, this->player_index, this->goal_x, this->goal_y, this->goal_width, this->goal_height, this->max_range) < std::tie(other.z, other.movement_mask, other.flying, other.player_index, other.goal_x, other.goal_y, other.goal_width, other.goal_height, other.max_range);
+	}
+
+	bool operator ==(const flow_field_key &other) const
+	{
+		return !(*this < other) && !(other < *this);
+	}
+
+	int z = 0;
+	tile_flag movement_mask;
+	bool flying = false;
+	int player_index = -1;
+	int goal_x = 0;
+	int goal_y = 0;
+	int goal_width = 0;
+	int goal_height = 0;
+	int max_range = 0;
+};
+
+//a field giving, for each tile of a map layer, the direction in which to move to get closer to a goal
+//it is calculated with a single reverse Dijkstra search from the goal, so that units moving to the same goal don't need a search each
+class flow_field final
+{
+public:
+	static constexpr char goal_direction = 8;
+	static constexpr char no_direction = -1;
+
+	explicit flow_field(const flow_field_key &key);
+
+	const flow_field_key &get_key() const
+	{
+		return this->key;
+	}
+
+	bool is_valid() const
+	{
+		return this->valid;
+	}
+
+	void set_invalid()
+	{
+		this->valid = false;
+	}
+
+	//get the direction (as an index of Heading2X and Heading2Y) in which to move from a tile, the goal direction if the tile is a goal tile, or no direction if the goal can't be reached from it
+	char get_direction(const QPoint &tile_pos) const;
+
+	//get the cost of reaching the goal from a tile, or -1 if it can't be reached
+	int get_cost(const QPoint &tile_pos) const;
+
+	//update the field for a changed tile, returning false if it can't be updated locally and needs to be recalculated
+	bool on_tile_changed(const QPoint &tile_pos);
+
+private:
+	using tile_queue = std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>>;
+
+	bool is_goal_tile(const QPoint &tile_pos) const;
+	bool is_tile_passable(const QPoint &tile_pos) const;
+	int get_tile_cost(const QPoint &tile_pos) const;
+	void calculate();
+	void propagate(tile_queue &queue);
+
+private:
+	flow_field_key key;
+	QSize map_size;
+	std::vector<int> costs;
+	std::vector<char> directions;
+	std::vector<int> tile_costs; //the cost of entering each tile with which the costs were calculated, or -1 if the tile hasn't been reached
+	bool valid = true;
+};
+
+//keeps the flow fields in use by units, so that units sharing a goal share a flow field
+class flow_field_cache final : public singleton<flow_field_cache>
+{
+public:
+	//the number of units which must request a path to the same goal in the same game cycle for a flow field to be created for them
+	static constexpr int min_group_size = 4;
+
+	//the minimum distance to the goal for a unit to use a flow field
+	static constexpr int min_distance = 8;
+
+	//get whether a unit can use a flow field for a path, and if so, fill the key for it
+	static bool get_key(const CUnit &unit, const QPoint &goal_pos, const QSize &goal_size, const int min_range, const int max_range, const int z, flow_field_key &key);
+
+	//get the flow field for a key, creating it if the key has been requested by enough units, or if the requesting unit was already using a flow field for it
+	std::shared_ptr<flow_field> request(const flow_field_key &key, const bool force);
+
+	void clear();
+	void on_tile_changed(const QPoint &tile_pos, const int z);
+
+private:
+	std::map<flow_field_key, std::weak_ptr<flow_field>> flow_fields;
+	std::map<flow_field_key, int> request_counts; //the requests for keys without a flow field in the current game cycle
+	unsigned long request_cycle = 0;
+};
+
+}
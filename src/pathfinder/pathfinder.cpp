@@ -36,6 +36,11 @@
 #include "map/map.h"
 #include "map/map_layer.h"
 #include "map/tile.h"
+#include "pathfinder/cluster_graph.h"
+#include "pathfinder/connectivity.h"
+#include "pathfinder/deposit_distance_field.h"
+#include "pathfinder/flow_field.h"
+#include "player.h"
 #include "unit/unit.h"
 #include "unit/unit_type.h"
 #include "util/size_util.h"
@@ -63,13 +68,33 @@ extern int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, in
 */
 //Wyrmgus end
 
+TerrainTraversal::~TerrainTraversal()
+{
+	if (m_buffer != nullptr) {
+		TerrainTraversal::get_free_buffers().push_back(std::move(m_buffer));
+	}
+}
+
 void TerrainTraversal::SetSize(unsigned int width, unsigned int height)
 {
-	m_values.resize((width + 2) * (height + 2));
-	m_extented_width = width + 2;
+	m_min_x = 0;
+	m_min_y = 0;
+	m_width = width;
 	m_height = height;
 }
 
+void TerrainTraversal::set_bounds(const QRect &rect, const int radius)
+{
+	const QRect map_rect(m_min_x, m_min_y, m_width, m_height);
+	const int window_radius = std::max(radius, 0);
+	const QRect window = rect.adjusted(-window_radius, -window_radius, window_radius, window_radius).intersected(map_rect);
+
+	m_min_x = window.x();
+	m_min_y = window.y();
+	m_width = std::max(window.width(), 0);
+	m_height = std::max(window.height(), 0);
+}
+
 void TerrainTraversal::SetDiagonalAllowed(const bool allowed)
 {
 	allow_diagonal = allowed;
@@ -77,17 +102,30 @@ void TerrainTraversal::SetDiagonalAllowed(const bool allowed)
 
 void TerrainTraversal::Init()
 {
-	const unsigned int height = m_height;
-	const unsigned int width = m_extented_width - 2;
-	const unsigned int width_ext = m_extented_width;
+	if (m_buffer == nullptr) {
+		std::vector<std::unique_ptr<buffer>> &free_buffers = TerrainTraversal::get_free_buffers();
+
+		if (free_buffers.empty()) {
+			m_buffer = std::make_unique<buffer>();
+		} else {
+			m_buffer = std::move(free_buffers.back());
+			free_buffers.pop_back();
+		}
+	}
+
+	const size_t size = static_cast<size_t>(m_width) * m_height;
+	if (m_buffer->stamps.size() < size) {
+		m_buffer->values.resize(size);
+		m_buffer->stamps.resize(size, 0);
+	}
+
+	++m_buffer->generation;
 
-	memset(&m_values[0], '\xFF', width_ext * sizeof(dataType));
-	for (unsigned i = 1; i < 1 + height; ++i) {
-		m_values[i * width_ext] = -1;
-		memset(&m_values[i * width_ext + 1], '\0', width * sizeof(dataType));
-		m_values[i * width_ext + width + 1] = -1;
+	if (m_buffer->generation == 0) {
+		//the generation has wrapped around, so clear the stamps, as they could otherwise be equal to the new generation
+		std::fill(m_buffer->stamps.begin(), m_buffer->stamps.end(), 0);
+		m_buffer->generation = 1;
 	}
-	memset(&m_values[(height + 1) * width_ext], '\xFF', width_ext * sizeof(dataType));
 }
 
 void TerrainTraversal::PushPos(const Vec2i &pos)
@@ -233,12 +271,35 @@ bool TerrainTraversal::IsInvalid(const Vec2i &pos) const
 
 TerrainTraversal::dataType TerrainTraversal::Get(const Vec2i &pos) const
 {
-	return m_values[m_extented_width + 1 + pos.y * m_extented_width + pos.x];
+	//positions outside the window are treated as the border around the map
+	const unsigned int x = static_cast<unsigned int>(pos.x - m_min_x);
+	const unsigned int y = static_cast<unsigned int>(pos.y - m_min_y);
+
+	if (x >= m_width || y >= m_height) {
+		return -1;
+	}
+
+	const size_t index = static_cast<size_t>(y) * m_width + x;
+
+	if (m_buffer->stamps[index] != m_buffer->generation) {
+		return 0;
+	}
+
+	return m_buffer->values[index];
 }
 
 void TerrainTraversal::Set(const Vec2i &pos, TerrainTraversal::dataType value)
 {
-	m_values[m_extented_width + 1 + pos.y * m_extented_width + pos.x] = value;
+	const size_t index = static_cast<size_t>(pos.y - m_min_y) * m_width + (pos.x - m_min_x);
+
+	m_buffer->stamps[index] = m_buffer->generation;
+	m_buffer->values[index] = value;
+}
+
+std::vector<std::unique_ptr<TerrainTraversal::buffer>> &TerrainTraversal::get_free_buffers()
+{
+	thread_local std::vector<std::unique_ptr<buffer>> free_buffers;
+	return free_buffers;
 }
 
 /**
@@ -250,6 +311,11 @@ void InitPathfinder()
 //	InitAStar(Map.Info.MapWidth, Map.Info.MapHeight);
 	InitAStar();
 	//Wyrmgus end
+
+	wyrmgus::hierarchical_pathfinder::get()->clear();
+	wyrmgus::flow_field_cache::get()->clear();
+	wyrmgus::connectivity::get()->clear();
+	wyrmgus::deposit_distance_field_cache::get()->clear();
 }
 
 /**
@@ -258,12 +324,58 @@ void InitPathfinder()
 void FreePathfinder()
 {
 	FreeAStar();
+
+	wyrmgus::hierarchical_pathfinder::get()->clear();
+	wyrmgus::flow_field_cache::get()->clear();
+	wyrmgus::connectivity::get()->clear();
+	wyrmgus::deposit_distance_field_cache::get()->clear();
+}
+
+/**
+**  Notify the pathfinder that the passability or movement cost of a tile may have changed
+**
+**  @param pos  The position of the tile
+**  @param z    The map layer of the tile
+*/
+void PathfinderTileChanged(const Vec2i &pos, int z)
+{
+	wyrmgus::hierarchical_pathfinder::get()->on_tile_changed(pos, z);
+	wyrmgus::flow_field_cache::get()->on_tile_changed(pos, z);
+	wyrmgus::connectivity::get()->on_tile_changed(pos, z);
+	wyrmgus::deposit_distance_field_cache::get()->on_tile_changed(pos, z);
 }
 
 /*----------------------------------------------------------------------------
 --  PATH-FINDER USE
 ----------------------------------------------------------------------------*/
 
+/**
+**  Check whether a goal certainly can't be reached from a position, because no tile near the goal is in the same connected component as the position.
+**
+**  @param src        Unit for the path.
+**  @param start_pos  The position from which the unit would move.
+**  @param goal_pos   Map tile position of the goal.
+**  @param w          Width of the goal.
+**  @param h          Height of the goal.
+**  @param range      Range to the goal.
+**  @param z          Map layer of the goal.
+**
+**  @return           True if the goal is unreachable, false if it may be reachable.
+*/
+static bool IsGoalDisconnected(const CUnit &src, const Vec2i &start_pos, const Vec2i &goal_pos, int w, int h, int range, int z)
+{
+	//without knowledge of unseen terrain, A* considers unexplored tiles crossable, so the check would leak information about them; AI players already rely on the real terrain (e.g. for landmasses), so they can still use it
+	if (!AStarKnowUnseenTerrain && !src.Player->AiEnabled) {
+		return false;
+	}
+
+	//include the positions from which the unit's other tiles would be in range
+	const int margin = range + std::max(src.Type->get_tile_width(), src.Type->get_tile_height());
+	const QRect goal_rect = QRect(goal_pos, QSize(std::max(w, 1), std::max(h, 1))).adjusted(-margin, -margin, margin, margin);
+
+	return !wyrmgus::connectivity::get()->can_reach(start_pos, goal_rect, src.Type->MovementMask, z);
+}
+
 /**
 **  Can the unit 'src' reach the place goalPos.
 **
@@ -289,6 +401,10 @@ int PlaceReachable(const CUnit &src, const Vec2i &goalPos, int w, int h, int min
 	
 	int i = PF_FAILED;
 	if (!src.Container || !from_outside_container) {
+		if (IsGoalDisconnected(src, src.tilePos, goalPos, w, h, range, z)) {
+			return 0;
+		}
+
 		i = AStarFindPath(src.tilePos, goalPos, w, h,
 						  src.Type->get_tile_width(), src.Type->get_tile_height(),
 						  minrange, range, nullptr, src, max_length, z);
@@ -299,7 +415,9 @@ int PlaceReachable(const CUnit &src, const Vec2i &goalPos, int w, int h, int min
 		const Vec2i end_pos = src.Container->tilePos + extra_tile_size + offset;
 		const Vec2i pos_diff = end_pos - start_pos;
 
-		int temp_i = PF_FAILED;
+		//the searches from each of the container's corners are independent from each other, so they can be done in parallel
+		std::vector<AStarPathRequest> requests;
+
 		for (Vec2i it = start_pos; it.y <= end_pos.y; it.y += pos_diff.y) {
 			for (it.x = start_pos.x; it.x <= end_pos.x; it.x += pos_diff.x) {
 				if (!CMap::Map.Info.IsPointOnMap(it, src.Container->MapLayer)) {
@@ -311,13 +429,29 @@ int PlaceReachable(const CUnit &src, const Vec2i &goalPos, int w, int h, int min
 					continue;
 				}
 
-				temp_i = AStarFindPath(it, goalPos, w, h,
-						  src.Type->get_tile_width(), src.Type->get_tile_height(),
-						  minrange, range, nullptr, src, max_length, z);
-						  
-				if (temp_i > i && i < PF_REACHED) {
-					i = temp_i;
+				if (IsGoalDisconnected(src, it, goalPos, w, h, range, z)) {
+					continue;
 				}
+
+				AStarPathRequest request;
+				request.StartPos = it;
+				request.GoalPos = goalPos;
+				request.GoalSize = Vec2i(w, h);
+				request.UnitSize = src.Type->get_tile_size();
+				request.MinRange = minrange;
+				request.MaxRange = range;
+				request.Unit = &src;
+				request.MaxLength = max_length;
+				request.MapLayer = z;
+				requests.push_back(std::move(request));
+			}
+		}
+
+		AStarFindPaths(requests);
+
+		for (const AStarPathRequest &request : requests) {
+			if (request.Result > i && i < PF_REACHED) {
+				i = request.Result;
 			}
 		}
 	}
@@ -455,6 +589,89 @@ void PathFinderInput::PathRacalculated()
 	isRecalculatePathNeeded = false;
 }
 
+/**
+**  Find a new path by following a flow field shared with other units moving to the same goal.
+**
+**  @param input   The pathfinder input of the unit.
+**  @param output  The pathfinder output of the unit, in which the path is stored.
+**
+**  @return        >0 remaining path length, or PF_FAILED if no flow field
+**                 could be used for the unit.
+*/
+static int NewFlowFieldPath(PathFinderInput &input, PathFinderOutput &output)
+{
+	CUnit &unit = *input.GetUnit();
+	PathFinderData &data = *unit.pathFinderData;
+	const int z = input.GetGoalMapLayer();
+
+	wyrmgus::flow_field_key key;
+	if (!wyrmgus::flow_field_cache::get_key(unit, input.GetGoalPos(), input.GetGoalSize(), input.GetMinRange(), input.GetMaxRange(), z, key)) {
+		data.flow_field.reset();
+		return PF_FAILED;
+	}
+
+	if (data.flow_field == nullptr || !data.flow_field->is_valid() || !(data.flow_field->get_key() == key)) {
+		//if the unit was already using a flow field for the same goal, it is part of a group which has been established, and so doesn't need to be counted again
+		const bool same_goal = data.flow_field != nullptr && data.flow_field->get_key() == key;
+		data.flow_field = wyrmgus::flow_field_cache::get()->request(key, same_goal);
+
+		if (data.flow_field == nullptr) {
+			return PF_FAILED;
+		}
+	}
+
+	const wyrmgus::flow_field &flow_field = *data.flow_field;
+	Vec2i pos = unit.tilePos;
+	char direction = flow_field.get_direction(pos);
+
+	if (direction == wyrmgus::flow_field::no_direction || direction == wyrmgus::flow_field::goal_direction) {
+		data.flow_field.reset();
+		return PF_FAILED;
+	}
+
+	//if the next tile is occupied, try to sidestep to another adjacent tile closer to the goal, so that units jammed at a chokepoint don't all fall back to A*
+	if (!UnitCanBeAt(unit, pos + Vec2i(Heading2X[direction], Heading2Y[direction]), z)) {
+		int best_cost = flow_field.get_cost(pos);
+		direction = wyrmgus::flow_field::no_direction;
+
+		for (size_t i = 0; i < 8; ++i) {
+			const Vec2i adjacent_pos = pos + Vec2i(Heading2X[i], Heading2Y[i]);
+
+			if (!CMap::Map.Info.IsPointOnMap(adjacent_pos, z)) {
+				continue;
+			}
+
+			const int adjacent_cost = flow_field.get_cost(adjacent_pos);
+			if (adjacent_cost >= 0 && adjacent_cost < best_cost && UnitCanBeAt(unit, adjacent_pos, z)) {
+				best_cost = adjacent_cost;
+				direction = static_cast<char>(i);
+			}
+		}
+
+		if (direction == wyrmgus::flow_field::no_direction) {
+			return PF_FAILED;
+		}
+	}
+
+	//the costs along the flow field's directions always decrease, so following them always leads to the goal
+	std::vector<char> path;
+	while (direction != wyrmgus::flow_field::goal_direction) {
+		path.push_back(direction);
+		pos += Vec2i(Heading2X[direction], Heading2Y[direction]);
+		direction = flow_field.get_direction(pos);
+	}
+
+	const int path_length = std::min<int>(path.size(), PathFinderOutput::MAX_PATH_LENGTH);
+	for (int i = 0; i < path_length; ++i) {
+		output.Path[path_length - i - 1] = path[i];
+	}
+
+	input.PathRacalculated();
+	output.Length = path_length;
+
+	return static_cast<int>(path.size());
+}
+
 /**
 **  Find new path.
 **
@@ -470,6 +687,28 @@ void PathFinderInput::PathRacalculated()
 */
 static int NewPath(PathFinderInput &input, PathFinderOutput &output)
 {
+	//units moving to the same goal as others share a flow field instead of searching for a path each
+	const int flow_field_result = NewFlowFieldPath(input, output);
+	if (flow_field_result != PF_FAILED) {
+		return flow_field_result;
+	}
+
+	//for distant goals, path towards a waypoint given by the cluster graph instead, so that the A* search stays local
+	const CUnit &unit = *input.GetUnit();
+	const QPoint waypoint = wyrmgus::hierarchical_pathfinder::get()->find_waypoint(unit, input.GetGoalPos(), input.GetGoalSize(), input.GetMaxRange(), input.GetGoalMapLayer());
+
+	if (waypoint != QPoint(-1, -1)) {
+		const int i = AStarFindPath(input.GetUnitPos(), waypoint, 0, 0,
+									input.GetUnitSize().x, input.GetUnitSize().y,
+									0, 0, &output.Path, unit, 0, input.GetGoalMapLayer());
+
+		if (i > 0) {
+			input.PathRacalculated();
+			output.Length = std::min<int>(i, PathFinderOutput::MAX_PATH_LENGTH);
+			return i;
+		}
+	}
+
 	int i = AStarFindPath(input.GetUnitPos(),
 						  input.GetGoalPos(),
 						  input.GetGoalSize().x, input.GetGoalSize().y,
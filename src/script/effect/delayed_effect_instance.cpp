@@ -106,7 +106,7 @@ void delayed_effect_instance<scope_type>::process_sml_scope(const sml_data &scop
 }
 
 template <typename scope_type>
-sml_data delayed_effect_instance<scope_type>::to_sml_data() const
+sml_data delayed_effect_instance<scope_type>::to_sml_data(const int remaining_cycles) const
 {
 	sml_data data;
 
@@ -130,7 +130,7 @@ sml_data delayed_effect_instance<scope_type>::to_sml_data() const
 	}
 	data.add_property("scope", std::move(scope));
 
-	data.add_property("remaining_cycles", std::to_string(this->get_remaining_cycles()));
+	data.add_property("remaining_cycles", std::to_string(remaining_cycles));
 
 	data.add_child(this->context.to_sml_data("context"));
 
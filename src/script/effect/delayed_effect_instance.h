@@ -62,20 +62,16 @@ public:
 	void process_sml_property(const sml_property &property);
 	void process_sml_scope(const sml_data &scope);
 
-	sml_data to_sml_data() const;
+	sml_data to_sml_data(const int remaining_cycles) const;
 
 	scope_type *get_scope() const;
 
+	//the cycles remaining when the delayed effect was created or loaded; afterwards the game keeps track of when it is due
 	int get_remaining_cycles() const
 	{
 		return this->remaining_cycles;
 	}
 
-	void decrement_remaining_cycles()
-	{
-		--this->remaining_cycles;
-	}
-
 	void do_effects();
 
 private:
@@ -234,6 +234,8 @@ int spell_action_adjust_variable::Cast(CUnit &caster, const spell &, CUnit *targ
 			continue;
 		}
 
+		unit->wake_up();
+
 		// Enable flag.
 		if (this->Var[i].ModifEnable) {
 			unit->Variable[i].Enable = this->Var[i].Enable;
@@ -248,9 +250,9 @@ int spell_action_adjust_variable::Cast(CUnit &caster, const spell &, CUnit *targ
 
 		// Increase field
 		if (this->Var[i].ModifIncrease) {
-			unit->Variable[i].Increase = this->Var[i].Increase;
+			unit->set_variable_increase(i, this->Var[i].Increase);
 		}
-		unit->Variable[i].Increase += this->Var[i].AddIncrease;
+		unit->change_variable_increase(i, this->Var[i].AddIncrease);
 
 		// Value field
 		if (this->Var[i].ModifValue) {
@@ -0,0 +1,173 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#include "stratagus.h"
+
+#include "cycle_profiler.h"
+
+namespace wyrmgus {
+
+const char *get_cycle_profiler_stage_name(const cycle_profiler_stage stage)
+{
+	switch (stage) {
+		case cycle_profiler_stage::network_commands:
+			return "network_commands";
+		case cycle_profiler_stage::triggers:
+			return "triggers";
+		case cycle_profiler_stage::unit_actions:
+			return "unit_actions";
+		case cycle_profiler_stage::missile_actions:
+			return "missile_actions";
+		case cycle_profiler_stage::players_each_cycle:
+			return "players_each_cycle";
+		case cycle_profiler_stage::map_layers:
+			return "map_layers";
+		case cycle_profiler_stage::players_each_second:
+			return "players_each_second";
+		case cycle_profiler_stage::players_each_half_minute:
+			return "players_each_half_minute";
+		case cycle_profiler_stage::players_each_minute:
+			return "players_each_minute";
+		case cycle_profiler_stage::ai_resource_manager:
+			return "ai_resource_manager";
+		case cycle_profiler_stage::ai_force_manager:
+			return "ai_force_manager";
+		default:
+			break;
+	}
+
+	throw std::runtime_error("Invalid cycle profiler stage: \"" + std::to_string(static_cast<int>(stage)) + "\".");
+}
+
+cycle_profiler::cycle_profiler() : epoch(clock::now()), samples(std::make_unique<sample[]>(cycle_profiler::capacity))
+{
+}
+
+void cycle_profiler::set_enabled(const bool enabled)
+{
+	if (enabled && !this->is_enabled()) {
+		this->epoch = clock::now();
+	}
+
+	this->enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void cycle_profiler::clear()
+{
+	this->sample_count.store(0, std::memory_order_release);
+	this->epoch = clock::now();
+}
+
+void cycle_profiler::add_sample(const cycle_profiler_stage stage, const clock::time_point &start, const clock::time_point &end)
+{
+	sample new_sample;
+	new_sample.stage = stage;
+	new_sample.cycle = GameCycle;
+	new_sample.start = std::chrono::duration_cast<std::chrono::microseconds>(start - this->epoch).count();
+	new_sample.duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+	//claim a slot before writing it, so that samples added concurrently don't overwrite each other
+	const size_t index = this->sample_count.fetch_add(1, std::memory_order_acq_rel);
+	this->samples[index % cycle_profiler::capacity] = new_sample;
+}
+
+std::vector<cycle_profiler::sample> cycle_profiler::get_samples() const
+{
+	const size_t count = this->sample_count.load(std::memory_order_acquire);
+	const size_t first_index = count > cycle_profiler::capacity ? count - cycle_profiler::capacity : 0;
+
+	std::vector<sample> samples;
+	samples.reserve(count - first_index);
+
+	for (size_t i = first_index; i < count; ++i) {
+		samples.push_back(this->samples[i % cycle_profiler::capacity]);
+	}
+
+	return samples;
+}
+
+std::array<cycle_profiler::stage_stats, static_cast<size_t>(cycle_profiler_stage::count)> cycle_profiler::get_stage_stats() const
+{
+	std::array<stage_stats, static_cast<size_t>(cycle_profiler_stage::count)> stats{};
+
+	for (const sample &profiler_sample : this->get_samples()) {
+		if (profiler_sample.stage >= cycle_profiler_stage::count) {
+			continue;
+		}
+
+		stage_stats &sample_stage_stats = stats[static_cast<size_t>(profiler_sample.stage)];
+		++sample_stage_stats.count;
+		sample_stage_stats.total_duration += profiler_sample.duration;
+		sample_stage_stats.max_duration = std::max(sample_stage_stats.max_duration, profiler_sample.duration);
+	}
+
+	return stats;
+}
+
+void cycle_profiler::save(const std::filesystem::path &filepath) const
+{
+	std::ofstream ofstream(filepath);
+
+	if (!ofstream) {
+		throw std::runtime_error("Failed to open file \"" + filepath.string() + "\" for saving the cycle profile.");
+	}
+
+	if (filepath.extension() == ".json") {
+		this->save_chrome_trace(ofstream);
+	} else {
+		this->save_csv(ofstream);
+	}
+}
+
+void cycle_profiler::save_csv(std::ofstream &ofstream) const
+{
+	ofstream << "cycle,stage,start_us,duration_us\n";
+
+	for (const sample &profiler_sample : this->get_samples()) {
+		ofstream << profiler_sample.cycle << ',' << get_cycle_profiler_stage_name(profiler_sample.stage) << ',' << profiler_sample.start << ',' << profiler_sample.duration << '\n';
+	}
+}
+
+void cycle_profiler::save_chrome_trace(std::ofstream &ofstream) const
+{
+	//complete events of the trace event format, which can be opened in chrome://tracing or Perfetto
+	ofstream << "{\"traceEvents\":[";
+
+	bool first = true;
+	for (const sample &profiler_sample : this->get_samples()) {
+		if (!first) {
+			ofstream << ',';
+		}
+		first = false;
+
+		ofstream << "\n{\"name\":\"" << get_cycle_profiler_stage_name(profiler_sample.stage) << "\",\"cat\":\"cycle\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << profiler_sample.start << ",\"dur\":" << profiler_sample.duration << ",\"args\":{\"cycle\":" << profiler_sample.cycle << "}}";
+	}
+
+	ofstream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+}
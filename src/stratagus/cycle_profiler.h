@@ -0,0 +1,124 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#pragma once
+
+#include "util/singleton.h"
+
+namespace wyrmgus {
+
+//the stages of a game cycle which are timed by the profiler
+enum class cycle_profiler_stage : uint8_t {
+	network_commands,
+	triggers,
+	unit_actions,
+	missile_actions,
+	players_each_cycle,
+	map_layers,
+	players_each_second,
+	players_each_half_minute,
+	players_each_minute,
+	ai_resource_manager,
+	ai_force_manager,
+
+	count
+};
+
+extern const char *get_cycle_profiler_stage_name(const cycle_profiler_stage stage);
+
+//times the stages of game cycles, keeping the most recent timings in a ring buffer
+//samples can be added from any thread without locking; reading them while they are being added may give a torn sample if the buffer wraps around in the meantime
+class cycle_profiler final : public singleton<cycle_profiler>
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr size_t capacity = 1 << 16;
+
+	struct sample final
+	{
+		cycle_profiler_stage stage = cycle_profiler_stage::count;
+		unsigned long cycle = 0;
+		int64_t start = 0; //in microseconds since the profiler was enabled
+		int64_t duration = 0; //in microseconds
+	};
+
+	//the timings of a stage over the samples in the buffer
+	struct stage_stats final
+	{
+		size_t count = 0;
+		int64_t total_duration = 0;
+		int64_t max_duration = 0;
+	};
+
+	template <typename function_type>
+	static void profile(const cycle_profiler_stage stage, const function_type &function)
+	{
+		cycle_profiler *profiler = cycle_profiler::get();
+
+		if (!profiler->is_enabled()) {
+			function();
+			return;
+		}
+
+		const clock::time_point start = clock::now();
+		function();
+		profiler->add_sample(stage, start, clock::now());
+	}
+
+	cycle_profiler();
+
+	bool is_enabled() const
+	{
+		return this->enabled.load(std::memory_order_relaxed);
+	}
+
+	void set_enabled(const bool enabled);
+
+	void clear();
+	void add_sample(const cycle_profiler_stage stage, const clock::time_point &start, const clock::time_point &end);
+
+	//get the samples in the buffer, from the oldest to the most recent
+	std::vector<sample> get_samples() const;
+
+	std::array<stage_stats, static_cast<size_t>(cycle_profiler_stage::count)> get_stage_stats() const;
+
+	//save the samples in the buffer, as Chrome trace JSON if the file has the ".json" extension, or as CSV otherwise
+	void save(const std::filesystem::path &filepath) const;
+
+private:
+	void save_csv(std::ofstream &ofstream) const;
+	void save_chrome_trace(std::ofstream &ofstream) const;
+
+private:
+	std::atomic<bool> enabled = false;
+	clock::time_point epoch;
+	std::unique_ptr<sample[]> samples;
+	std::atomic<size_t> sample_count = 0; //the number of samples ever added since the buffer was last cleared
+};
+
+}
@@ -50,6 +50,14 @@ int main(int argc, char **argv)
 	try {
 		qInstallMessageHandler(log::log_qt_message);
 
+		//headless runs don't open any window, so use a platform plugin which doesn't need a display
+		for (int i = 1; i < argc; ++i) {
+			if (std::string_view(argv[i]) == "--headless") {
+				qputenv("QT_QPA_PLATFORM", "offscreen");
+				break;
+			}
+		}
+
 		QApplication app(argc, argv);
 		app.setApplicationName(NAME);
 		app.setApplicationVersion(VERSION);
@@ -81,32 +89,35 @@ int main(int argc, char **argv)
 
 		QQmlApplicationEngine engine;
 
-		qmlRegisterType<defines>();
-		qmlRegisterType<game>();
-		qmlRegisterType<parameters>();
-		qmlRegisterType<preferences>();
+		//headless runs have no interface, so the engine thread is run without it
+		if (!parameters::get()->is_headless()) {
+			qmlRegisterType<defines>();
+			qmlRegisterType<game>();
+			qmlRegisterType<parameters>();
+			qmlRegisterType<preferences>();
 
-		qmlRegisterType<frame_buffer_object>("frame_buffer_object", 1, 0, "FrameBufferObject");
+			qmlRegisterType<frame_buffer_object>("frame_buffer_object", 1, 0, "FrameBufferObject");
 
-		engine.rootContext()->setContextProperty("wyrmgus", engine_interface::get());
+			engine.rootContext()->setContextProperty("wyrmgus", engine_interface::get());
 
-		engine.addImageProvider("interface", new interface_image_provider);
+			engine.addImageProvider("interface", new interface_image_provider);
 
-		const QString root_path = QString::fromStdString(database::get()->get_root_path().string());
+			const QString root_path = QString::fromStdString(database::get()->get_root_path().string());
 
-		app.setWindowIcon(QIcon(root_path + "/graphics/interface/icons/wyrmsun_icon_32.png"));
+			app.setWindowIcon(QIcon(root_path + "/graphics/interface/icons/wyrmsun_icon_32.png"));
 
-		engine.addImportPath(root_path + "/libraries/qml");
+			engine.addImportPath(root_path + "/libraries/qml");
 
-		QUrl url = QDir(root_path + "/interface/").absoluteFilePath("Main.qml");
-		url.setScheme("file");
-		QObject::connect(
-				&engine, &QQmlApplicationEngine::objectCreated, &app,
-				[url](QObject *obj, const QUrl &objUrl) {
-					if (!obj && url == objUrl) QCoreApplication::exit(-1);
-				},
-				Qt::QueuedConnection);
-		engine.load(url);
+			QUrl url = QDir(root_path + "/interface/").absoluteFilePath("Main.qml");
+			url.setScheme("file");
+			QObject::connect(
+					&engine, &QQmlApplicationEngine::objectCreated, &app,
+					[url](QObject *obj, const QUrl &objUrl) {
+						if (!obj && url == objUrl) QCoreApplication::exit(-1);
+					},
+					Qt::QueuedConnection);
+			engine.load(url);
+		}
 
 		const int result = app.exec();
 
@@ -32,6 +32,7 @@
 #include "character.h"
 #include "civilization.h"
 #include "commands.h"
+#include "cycle_profiler.h"
 #include "database/defines.h"
 #include "dialogue.h"
 #include "editor.h"
@@ -48,6 +49,7 @@
 #include "map/terrain_type.h"
 #include "missile.h"
 #include "network.h"
+#include "parameters.h"
 #include "particle.h"
 #include "quest/campaign.h"
 //Wyrmgus start
@@ -76,6 +78,7 @@
 #include "unit/unit_manager.h"
 #include "upgrade/upgrade.h"
 //Wyrmgus end
+#include "util/exception_util.h"
 #include "video/font.h"
 #include "video/video.h"
 
@@ -92,6 +95,8 @@ int MouseScrollState = ScrollNone;
 EventCallback GameCallbacks;   /// Game callbacks
 EventCallback EditorCallbacks; /// Editor callbacks
 
+int HeadlessExitCode = EXIT_SUCCESS; /// 1 if a headless run ended in defeat, 2 if it reached the cycle limit, 0 otherwise
+
 /**
 **  Handle scrolling area.
 **
@@ -297,6 +302,8 @@ static void InitGameCallbacks()
 
 static void GameLogicLoop()
 {
+	const bool headless = parameters::get()->is_headless();
+
 	// Can't find a better place.
 	// FIXME: We need to find a better place!
 	SaveGameLoading = false;
@@ -308,16 +315,18 @@ static void GameLogicLoop()
 		SinglePlayerReplayEachCycle();
 		++GameCycle;
 		MultiPlayerReplayEachCycle();
-		NetworkCommands(); // Get network commands
-		TriggersEachCycle();// handle triggers
-		UnitActions();      // handle units
-		MissileActions();   // handle missiles
-		PlayersEachCycle(); // handle players
+		cycle_profiler::profile(cycle_profiler_stage::network_commands, NetworkCommands); // Get network commands
+		cycle_profiler::profile(cycle_profiler_stage::triggers, TriggersEachCycle); // handle triggers
+		cycle_profiler::profile(cycle_profiler_stage::unit_actions, UnitActions); // handle units
+		cycle_profiler::profile(cycle_profiler_stage::missile_actions, MissileActions); // handle missiles
+		cycle_profiler::profile(cycle_profiler_stage::players_each_cycle, PlayersEachCycle); // handle players
 		UpdateTimer();      // update game timer
 
-		for (const std::unique_ptr<CMapLayer> &map_layer : CMap::Map.MapLayers) {
-			map_layer->DoPerCycleLoop();
-		}
+		cycle_profiler::profile(cycle_profiler_stage::map_layers, []() {
+			for (const std::unique_ptr<CMapLayer> &map_layer : CMap::Map.MapLayers) {
+				map_layer->DoPerCycleLoop();
+			}
+		});
 		
 		//
 		// Work todo each second.
@@ -333,7 +342,9 @@ static void GameLogicLoop()
 			case 0: // At cycle 0, start all ai players...
 				if (GameCycle == 0) {
 					for (int player = 0; player < NumPlayers; ++player) {
-						PlayersEachSecond(player);
+						cycle_profiler::profile(cycle_profiler_stage::players_each_second, [player]() {
+							PlayersEachSecond(player);
+						});
 					}
 				}
 				break;
@@ -371,22 +382,28 @@ static void GameLogicLoop()
 		int player = (GameCycle - 1) % CYCLES_PER_SECOND;
 		Assert(player >= 0);
 		if (player < NumPlayers) {
-			PlayersEachSecond(player);
-			if ((player + CYCLES_PER_SECOND) < NumPlayers) {
-				PlayersEachSecond(player + CYCLES_PER_SECOND);
-			}
+			cycle_profiler::profile(cycle_profiler_stage::players_each_second, [player]() {
+				PlayersEachSecond(player);
+				if ((player + CYCLES_PER_SECOND) < NumPlayers) {
+					PlayersEachSecond(player + CYCLES_PER_SECOND);
+				}
+			});
 		}
 		
 		player = (GameCycle - 1) % (CYCLES_PER_MINUTE / 2);
 		Assert(player >= 0);
 		if (player < NumPlayers) {
-			PlayersEachHalfMinute(player);
+			cycle_profiler::profile(cycle_profiler_stage::players_each_half_minute, [player]() {
+				PlayersEachHalfMinute(player);
+			});
 		}
 
 		player = (GameCycle - 1) % CYCLES_PER_MINUTE;
 		Assert(player >= 0);
 		if (player < NumPlayers) {
-			PlayersEachMinute(player);
+			cycle_profiler::profile(cycle_profiler_stage::players_each_minute, [player]() {
+				PlayersEachMinute(player);
+			});
 		}
 		//Wyrmgus end
 		
@@ -404,11 +421,15 @@ static void GameLogicLoop()
 	}
 
 	UpdateMessages();     // update messages
-	ParticleManager.update(); // handle particles
-	CheckMusicFinished(); // Check for next song
 
-	if (FastForwardCycle <= GameCycle || !(GameCycle & 0x3f)) {
-		WaitEventsOneFrame();
+	//headless runs have no display or sound, and don't wait for the next frame
+	if (!headless) {
+		ParticleManager.update(); // handle particles
+		CheckMusicFinished(); // Check for next song
+
+		if (FastForwardCycle <= GameCycle || !(GameCycle & 0x3f)) {
+			WaitEventsOneFrame();
+		}
 	}
 
 	if (!NetworkInSync) {
@@ -479,6 +500,64 @@ static void SingleGameLoop()
 	}
 }
 
+static const char *GetGameResultName(const GameResults result)
+{
+	switch (result) {
+		case GameVictory:
+			return "victory";
+		case GameDefeat:
+			return "defeat";
+		case GameDraw:
+			return "draw";
+		case GameQuitToMenu:
+			return "quit to menu";
+		case GameRestart:
+			return "restart";
+		case GameExit:
+			return "exit";
+		default:
+			return "none";
+	}
+}
+
+/**
+**  Run the game logic as fast as possible, without display, until the game is over or the cycle limit is reached, and then print the final sync hash and the timing.
+*/
+static void HeadlessGameLoop()
+{
+	const unsigned long cycle_limit = parameters::get()->get_headless_cycle_limit();
+	const unsigned long start_cycle = GameCycle;
+	const auto start_time = std::chrono::steady_clock::now();
+	bool cycle_limit_reached = false;
+
+	while (GameRunning) {
+		engine_interface::get()->run_event_loop();
+
+		GameLogicLoop();
+
+		if (cycle_limit != 0 && GameCycle >= cycle_limit) {
+			cycle_limit_reached = true;
+			StopGame(GameExit);
+		}
+	}
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+	const unsigned long cycles = GameCycle - start_cycle;
+	const double seconds = elapsed.count();
+
+	fprintf(stdout, "Headless run finished at cycle %lu (%s): %lu cycles in %.3f s (%.1f cycles/s), SyncHash %u\n",
+		GameCycle, cycle_limit_reached ? "cycle limit" : GetGameResultName(GameResult), cycles, seconds, seconds > 0 ? cycles / seconds : 0., SyncHash);
+	fflush(stdout);
+
+	if (cycle_limit_reached) {
+		HeadlessExitCode = 2;
+	} else if (GameResult == GameDefeat) {
+		HeadlessExitCode = 1;
+	} else {
+		HeadlessExitCode = EXIT_SUCCESS;
+	}
+}
+
 /**
 **  Game main loop.
 **
@@ -557,7 +636,27 @@ void GameMainLoop()
 	}
 	//Wyrmgus end
 
-	SingleGameLoop();
+	const std::filesystem::path &profile_filepath = parameters::get()->get_profile_filepath();
+	if (!profile_filepath.empty()) {
+		cycle_profiler::get()->clear();
+		cycle_profiler::get()->set_enabled(true);
+	}
+
+	if (parameters::get()->is_headless()) {
+		HeadlessGameLoop();
+	} else {
+		SingleGameLoop();
+	}
+
+	if (!profile_filepath.empty()) {
+		cycle_profiler::get()->set_enabled(false);
+
+		try {
+			cycle_profiler::get()->save(profile_filepath);
+		} catch (const std::exception &exception) {
+			exception::report(exception);
+		}
+	}
 
 #ifdef REALVIDEO
 	if (FastForwardCycle > GameCycle) {
@@ -576,4 +675,9 @@ void GameMainLoop()
 	GodMode = false;
 
 	SetCallbacks(old_callbacks);
+
+	if (parameters::get()->is_headless()) {
+		//there are no menus to return to, so make them stop as when exiting, so that the engine returns to stratagusMain and exits with the headless exit code
+		GameResult = GameExit;
+	}
 }
@@ -34,6 +34,11 @@
 
 namespace wyrmgus {
 
+bool parameters::is_long_option_with_value(const std::string_view &name)
+{
+	return name == "cycles" || name == "profile";
+}
+
 void parameters::process()
 {
 	QCommandLineParser cmd_parser;
@@ -44,6 +49,15 @@ void parameters::process()
 	QCommandLineOption test_option{ "t", "Check startup and exit." };
 	cmd_parser.addOption(test_option);
 
+	QCommandLineOption headless_option{ "headless", "Run the game given on the command line without display or sound, as fast as possible, and print its final sync hash." };
+	cmd_parser.addOption(headless_option);
+
+	QCommandLineOption cycles_option("cycles", "Stop a headless run after the given number of game cycles, instead of when the game is over.", "cycles");
+	cmd_parser.addOption(cycles_option);
+
+	QCommandLineOption profile_option("profile", "Time the stages of each game cycle, and save the timings to the given file when the game ends, as Chrome trace JSON if it has the \".json\" extension, or as CSV otherwise.", "file");
+	cmd_parser.addOption(profile_option);
+
 	cmd_parser.setApplicationDescription("The free real time strategy game engine.");
 	cmd_parser.addHelpOption();
 	cmd_parser.addVersionOption();
@@ -58,6 +72,23 @@ void parameters::process()
 		this->test_run = true;
 	}
 
+	if (cmd_parser.isSet(headless_option)) {
+		this->headless = true;
+	}
+
+	if (cmd_parser.isSet(cycles_option)) {
+		bool ok = false;
+		this->headless_cycle_limit = cmd_parser.value(cycles_option).toULong(&ok);
+
+		if (!ok) {
+			throw std::runtime_error("Invalid number of cycles: \"" + cmd_parser.value(cycles_option).toStdString() + "\".");
+		}
+	}
+
+	if (cmd_parser.isSet(profile_option)) {
+		this->profile_filepath = cmd_parser.value(profile_option).toStdString();
+	}
+
 	//FIXME: add the command line parsing from ParseCommandLine() here
 
 	this->SetDefaultUserDirectory();
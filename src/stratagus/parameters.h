@@ -36,8 +36,12 @@ class parameters final : public QObject, public singleton<parameters>
 	Q_OBJECT
 
 	Q_PROPERTY(bool test_run READ is_test_run CONSTANT)
+	Q_PROPERTY(bool headless READ is_headless CONSTANT)
 
 public:
+	//get whether a long option takes the next argument as its value, if its value isn't given with '='
+	static bool is_long_option_with_value(const std::string_view &name);
+
 	void process();
 	void SetLocalPlayerNameFromEnv();
 
@@ -46,6 +50,21 @@ public:
 		return this->test_run;
 	}
 
+	bool is_headless() const
+	{
+		return this->headless;
+	}
+
+	unsigned long get_headless_cycle_limit() const
+	{
+		return this->headless_cycle_limit;
+	}
+
+	const std::filesystem::path &get_profile_filepath() const
+	{
+		return this->profile_filepath;
+	}
+
 	void SetUserDirectory(const std::string &path) { userDirectory = path; }
 	const std::string &GetUserDirectory() const { return userDirectory; }
 
@@ -59,6 +78,9 @@ public:
 	std::string LocalPlayerName;        /// Name of local player
 private:
 	bool test_run = false;
+	bool headless = false; //whether to run the game logic without display or sound
+	unsigned long headless_cycle_limit = 0; //the number of game cycles after which a headless run stops, or 0 to run until the game is over
+	std::filesystem::path profile_filepath; //the file to which the game cycle timings are saved when a game ends, if any
 	std::string userDirectory;          /// Directory containing user settings and data
 };
 
@@ -449,6 +449,7 @@ void CleanPlayers()
 {
 	CPlayer::SetThisPlayer(nullptr);
 	CPlayer::revealed_players.clear();
+	CPlayer::revealed_player_mask = 0;
 	for (unsigned int i = 0; i < PlayerMax; ++i) {
 		CPlayer::Players[i]->Clear();
 	}
@@ -528,8 +529,23 @@ void CPlayer::set_revealed(const bool revealed)
 
 	if (revealed) {
 		CPlayer::revealed_players.push_back(this);
+		CPlayer::revealed_player_mask |= static_cast<uint64_t>(1) << this->Index;
 	} else {
 		wyrmgus::vector::remove(CPlayer::revealed_players, this);
+		CPlayer::revealed_player_mask &= ~(static_cast<uint64_t>(1) << this->Index);
+	}
+}
+
+void CPlayer::update_mutual_shared_vision_masks()
+{
+	for (CPlayer *player : CPlayer::Players) {
+		player->mutual_shared_vision_mask = 0;
+
+		for (const int i : player->get_shared_vision()) {
+			if (CPlayer::Players[i]->has_shared_vision_with(player->Index)) {
+				player->mutual_shared_vision_mask |= static_cast<uint64_t>(1) << i;
+			}
+		}
 	}
 }
 
@@ -2204,6 +2220,7 @@ void CPlayer::Clear()
 	this->enemies.clear();
 	this->allies.clear();
 	this->shared_vision.clear();
+	this->mutual_shared_vision_mask = 0;
 	this->StartPos.x = 0;
 	this->StartPos.y = 0;
 	//Wyrmgus start
@@ -4048,6 +4065,7 @@ void CPlayer::SetDiplomacyCrazyWith(const CPlayer &player)
 void CPlayer::ShareVisionWith(const CPlayer &player)
 {
 	this->shared_vision.insert(player.Index);
+	CPlayer::update_mutual_shared_vision_masks();
 	
 	if (GameCycle > 0 && player.Index == CPlayer::GetThisPlayer()->Index) {
 		CPlayer::GetThisPlayer()->Notify(_("%s is now sharing vision with us"), _(this->Name.c_str()));
@@ -4057,6 +4075,7 @@ void CPlayer::ShareVisionWith(const CPlayer &player)
 void CPlayer::UnshareVisionWith(const CPlayer &player)
 {
 	this->shared_vision.erase(player.Index);
+	CPlayer::update_mutual_shared_vision_masks();
 	
 	if (GameCycle > 0 && player.Index == CPlayer::GetThisPlayer()->Index) {
 		CPlayer::GetThisPlayer()->Notify(_("%s is no longer sharing vision with us"), _(this->Name.c_str()));
@@ -4176,6 +4195,16 @@ bool CPlayer::IsEnemy(const CUnit &unit) const
 	return IsEnemy(*unit.Player);
 }
 
+uint64_t CPlayer::get_potential_enemy_owner_mask() const
+{
+	//units of other players may be enemies regardless of diplomacy, e.g. if they have hidden ownership, and the neutral player's fauna may attack each other, so only this player's own units can be left out
+	if (this->Type == PlayerNeutral || this->IsEnemy(*this)) {
+		return ~static_cast<uint64_t>(0);
+	}
+
+	return ~(static_cast<uint64_t>(1) << this->Index);
+}
+
 /**
 **  Check if the player is an ally
 */
@@ -200,6 +200,7 @@ void CPlayer::Load(lua_State *l)
 					this->shared_vision.insert(i);
 				}
 			}
+			CPlayer::update_mutual_shared_vision_masks();
 		} else if (!strcmp(value, "start")) {
 			CclGetPos(l, &this->StartPos.x, &this->StartPos.y, j + 1);
 		//Wyrmgus start
@@ -254,7 +254,9 @@ static int MenuLoop()
 	initGuichan();
 	current_interface_state = interface_state::menu;
 	//  Clear screen
-	Video.ClearScreen();
+	if (!parameters::get()->is_headless()) {
+		Video.ClearScreen();
+	}
 
 	ButtonUnderCursor = -1;
 	OldButtonUnderCursor = -1;
@@ -409,6 +411,10 @@ static void Usage()
 		"\t-u userpath\tPath where stratagus saves preferences, log and savegame\n"
 		"\t-v mode\t\tVideo mode resolution in format <xres>x<yres>\n"
 		"\t-W\t\tWindowed video mode\n"
+		"\t--headless\tRun the map without display or sound, as fast as possible, and print its final sync hash;\n"
+		"\t  \t\texits with 1 on defeat and 2 when stopped by --cycles\n"
+		"\t--cycles n\tStop a headless run after n game cycles, instead of when the game is over\n"
+		"\t--profile file\tSave the timings of the game cycle stages to a CSV or Chrome trace JSON file when the game ends\n"
 #if defined(USE_OPENGL) || defined(USE_GLES)
 		"\t-x idx\t\tControls fullscreen scaling if your graphics card supports shaders.\n"\
 		"\t  \t\tPass 1 for nearest-neigubour, 2 for EPX/AdvMame, 3 for HQx, 4 for SAL, 5 for SuperEagle\n"\
@@ -468,6 +474,26 @@ static void ParseCommandLine(int argc, char **argv)
 {
 	parameters *parameters = parameters::get();
 
+	//long options are only handled by the Qt command line parser, so leave them (and values given to them as separate arguments) out of the arguments parsed here
+	std::vector<char *> arguments;
+	for (int i = 0; i < argc; ++i) {
+		const std::string_view argument = argv[i];
+
+		if (i > 0 && argument.size() > 2 && argument.starts_with("--")) {
+			if (argument.find('=') == std::string_view::npos && parameters::is_long_option_with_value(argument.substr(2))) {
+				++i;
+			}
+
+			continue;
+		}
+
+		arguments.push_back(argv[i]);
+	}
+
+	argc = static_cast<int>(arguments.size());
+	arguments.push_back(nullptr);
+	argv = arguments.data();
+
 	for (;;) {
 		switch (getopt(argc, argv, "ac:d:D:eE:FG:hiI:lN:oOP:ps:S:tu:v:Wx:Z?-")) {
 			case 'c':
@@ -646,19 +672,23 @@ void stratagusMain(int argc, char **argv)
 	PrintHeader();
 	PrintLicense();
 
-	// Setup video display
-	InitVideo();
+	if (parameters->is_headless()) {
+		InitHeadlessSdl();
+	} else {
+		// Setup video display
+		InitVideo();
+
+		//setup sound
+		if (InitSound()) {
+			InitMusic();
+		}
 
-	//setup sound
-	if (InitSound()) {
-		InitMusic();
+		//  Show title screens.
+		SetClipping(0, 0, Video.Width - 1, Video.Height - 1);
+		Video.ClearScreen();
+		ShowTitleScreens();
 	}
 
-	//  Show title screens.
-	SetClipping(0, 0, Video.Width - 1, Video.Height - 1);
-	Video.ClearScreen();
-	ShowTitleScreens();
-
 	// Init player data
 	CPlayer::SetThisPlayer(nullptr);
 	//Don't clear the Players structure as it would erase the allowed units.
@@ -677,7 +707,7 @@ void stratagusMain(int argc, char **argv)
 		return;
 	}
 
-	Exit(0);
+	Exit(parameters->is_headless() ? HeadlessExitCode : 0);
 }
 
 //Wyrmgus start
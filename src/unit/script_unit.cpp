@@ -717,6 +717,7 @@ static int CclUnit(lua_State *l)
 			if (index != -1) { // Valid index
 				lua_rawgeti(l, 2, j + 1);
 				DefineVariableField(l, unit->Variable[index], -1);
+				unit->update_increasing_variable(index);
 				lua_pop(l, 1);
 				continue;
 			}
@@ -1880,6 +1881,7 @@ static int CclSetUnitVariable(lua_State *l)
 	lua_pushvalue(l, 1);
 	CUnit *unit = CclGetUnit(l);
 	lua_pop(l, 1);
+	unit->wake_up();
 	const char *const name = LuaToString(l, 2);
 	//Wyrmgus start
 //	int value;
@@ -1894,7 +1896,7 @@ static int CclSetUnitVariable(lua_State *l)
 	//Wyrmgus end
 	} else if (!strcmp(name, "RegenerationRate")) {
 		value = LuaToNumber(l, 3);
-		unit->Variable[HP_INDEX].Increase = std::min(unit->Variable[HP_INDEX].Max, value);
+		unit->set_variable_increase(HP_INDEX, std::min(unit->Variable[HP_INDEX].Max, value));
 	} else if (!strcmp(name, "IndividualUpgrade")) {
 		LuaCheckArgs(l, 4);
 		std::string upgrade_ident = LuaToString(l, 3);
@@ -2027,7 +2029,7 @@ static int CclSetUnitVariable(lua_State *l)
 			} else if (!strcmp(type, "Max")) {
 				unit->Variable[index].Max = value;
 			} else if (!strcmp(type, "Increase")) {
-				unit->Variable[index].Increase = value;
+				unit->set_variable_increase(index, value);
 			} else if (!strcmp(type, "Enable")) {
 				unit->Variable[index].Enable = value;
 			} else {
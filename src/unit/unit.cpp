@@ -58,6 +58,7 @@
 #include "map/map.h"
 #include "map/map_layer.h"
 #include "map/plane.h"
+#include "map/resource_index.h"
 #include "map/site.h"
 #include "map/site_game_data.h"
 #include "map/terrain_type.h"
@@ -89,6 +90,7 @@
 #include "ui/interface.h"
 #include "ui/ui.h"
 #include "unit/unit_find.h"
+#include "unit/unit_grid.h"
 #include "unit/unit_manager.h"
 #include "unit/unit_ref.h"
 #include "unit/unit_type.h"
@@ -477,6 +479,7 @@ void CUnit::Init()
 	this->VisCount.fill(0);
 	this->Seen = _seen_stuff_();
 	this->Variable.clear();
+	this->increasing_variables.clear();
 	TTL = 0;
 	Threshold = 0;
 	GroupId = 0;
@@ -486,7 +489,6 @@ void CUnit::Init()
 	Blink = 0;
 	Moving = 0;
 	ReCast = 0;
-	CacheLock = 0;
 	Summoned = 0;
 	Waiting = 0;
 	MineLow = 0;
@@ -495,6 +497,7 @@ void CUnit::Init()
 	this->GivesResource = 0;
 	this->CurrentResource = 0;
 	this->reset_step_count();
+	this->wake_up();
 	this->Orders.clear();
 	this->clear_special_orders();
 	this->autocast_spells.clear();
@@ -906,6 +909,7 @@ void CUnit::HealingItemAutoUse()
 			) {
 				if (this->CriticalOrder == nullptr) {
 					this->CriticalOrder = COrder::NewActionUse(*uins);
+					this->wake_up();
 				}
 				break;
 			}
@@ -969,6 +973,7 @@ void CUnit::apply_character_properties()
 		}
 
 		this->Variable = this->get_character()->get_unit_type()->Stats[this->Player->Index].Variables;
+		this->update_increasing_variables();
 	} else {
 		fprintf(stderr, "Character \"%s\" has no unit type.\n", character->get_identifier().c_str());
 		return;
@@ -1293,6 +1298,9 @@ void CUnit::ChooseVariation(const wyrmgus::unit_type *new_type, bool ignore_old_
 
 void CUnit::SetVariation(const wyrmgus::unit_type_variation *new_variation, const int image_layer)
 {
+	//the variation may have animations of its own
+	this->wake_up();
+
 	if (image_layer == -1) {
 		if (
 			(this->GetVariation() != nullptr && this->GetVariation()->get_animation_set() != nullptr)
@@ -1596,7 +1604,7 @@ void CUnit::EquipItem(CUnit &item, bool affect_character)
 		} else if (i == HITPOINTBONUS_INDEX) {
 			Variable[HP_INDEX].Value += item.Variable[i].Value;
 			Variable[HP_INDEX].Max += item.Variable[i].Max;
-			Variable[HP_INDEX].Increase += item.Variable[i].Increase;
+			this->change_variable_increase(HP_INDEX, item.Variable[i].Increase);
 		} else if (i == SIGHTRANGE_INDEX || i == DAYSIGHTRANGEBONUS_INDEX || i == NIGHTSIGHTRANGEBONUS_INDEX) {
 			if (!SaveGameLoading) {
 				MapUnmarkUnitSight(*this);
@@ -1633,7 +1641,7 @@ void CUnit::DeequipItem(CUnit &item, bool affect_character)
 		} else if (i == HITPOINTBONUS_INDEX) {
 			Variable[HP_INDEX].Value -= item.Variable[i].Value;
 			Variable[HP_INDEX].Max -= item.Variable[i].Max;
-			Variable[HP_INDEX].Increase -= item.Variable[i].Increase;
+			this->change_variable_increase(HP_INDEX, -item.Variable[i].Increase);
 		} else if (i == SIGHTRANGE_INDEX || i == DAYSIGHTRANGEBONUS_INDEX || i == NIGHTSIGHTRANGEBONUS_INDEX) {
 			MapUnmarkUnitSight(*this);
 			Variable[i].Value -= item.Variable[i].Value;
@@ -1840,6 +1848,7 @@ void CUnit::ApplyAuraEffect(int aura_index)
 		return;
 	}
 	
+	this->wake_up();
 	this->Variable[effect_index].Enable = 1;
 	this->Variable[effect_index].Max = std::max(CYCLES_PER_SECOND + 1, this->Variable[effect_index].Max);
 	this->Variable[effect_index].Value = std::max(CYCLES_PER_SECOND + 1, this->Variable[effect_index].Value);
@@ -2680,6 +2689,10 @@ void CUnit::ProduceResource(const wyrmgus::resource *resource)
 		this->GivesResource = 0;
 		this->ResourcesHeld = 0;
 	}
+
+	if (!this->Removed) {
+		this->MapLayer->get_resource_index()->on_unit_given_resource_changed(this, old_resource);
+	}
 	
 	if (old_resource != 0) {
 		for (const std::shared_ptr<wyrmgus::unit_ref> &uins_ref : this->Resource.Workers) {
@@ -2830,6 +2843,7 @@ void CUnit::Init(const wyrmgus::unit_type &type, const bool loading_saved_unit)
 	} else {
 		this->Variable.clear();
 	}
+	this->update_increasing_variables();
 
 	IndividualUpgrades.clear();
 
@@ -2998,12 +3012,19 @@ void CUnit::AssignToPlayer(CPlayer &player)
 //		}
 		//Wyrmgus end
 	}
+	const CPlayer *old_player = this->Player;
 	Player = &player;
 	Stats = &type.Stats[Player->Index];
+
+	//the unit grid of the map layer partitions the units on it by owner
+	if (old_player != nullptr && old_player != this->Player && this->MapLayer != nullptr && !this->Removed) {
+		this->MapLayer->get_unit_grid()->on_unit_owner_changed(this, old_player->Index);
+	}
 	if (!SaveGameLoading) {
 		if (UnitTypeVar.GetNumberVariable()) {
 			Assert(!Stats->Variables.empty());
 			this->Variable = Stats->Variables;
+			this->update_increasing_variables();
 		}
 	}
 	
@@ -3267,6 +3288,61 @@ void MapUnmarkUnitSight(CUnit &unit)
 	}
 }
 
+/**
+**  Move on vision table the Sight of the unit from an old position to its current one
+**  (and units inside for transporter (recursively))
+**
+**  @param unit     Unit whose sight to move.
+**  @param old_pos  Old coord of first container of unit.
+**  @param new_pos  New coord of first container of unit.
+**  @param width    Width of the first container of unit.
+**  @param height   Height of the first container of unit.
+*/
+static void MapMoveUnitSightRec(const CUnit &unit, const Vec2i &old_pos, const Vec2i &new_pos, int width, int height)
+{
+	const int range = unit.Container && unit.Container->CurrentSightRange >= unit.CurrentSightRange ? unit.Container->CurrentSightRange : unit.CurrentSightRange;
+
+	MapSightMove<MapUnmarkTileSight, MapMarkTileSight>(*unit.Player, old_pos, new_pos, width, height, range, unit.MapLayer->ID);
+
+	if (unit.Type && unit.Type->BoolFlag[DETECTCLOAK_INDEX].value) {
+		MapSightMove<MapUnmarkTileDetectCloak, MapMarkTileDetectCloak>(*unit.Player, old_pos, new_pos, width, height, range, unit.MapLayer->ID);
+	}
+
+	if (unit.Variable[ETHEREALVISION_INDEX].Value) {
+		MapSightMove<MapUnmarkTileDetectEthereal, MapMarkTileDetectEthereal>(*unit.Player, old_pos, new_pos, width, height, range, unit.MapLayer->ID);
+	}
+
+	CUnit *unit_inside = unit.UnitInside;
+	for (int i = unit.InsideCount; i--; unit_inside = unit_inside->NextContained) {
+		MapMoveUnitSightRec(*unit_inside, old_pos, new_pos, width, height);
+	}
+}
+
+/**
+**  Move on vision table the Sight of a unit on the map from an old position to its current one
+**  (and units inside for transporter)
+**
+**  This has the same effect as MapUnmarkUnitSight at the old position followed by MapMarkUnitSight at the new one, but only touches the tiles which leave or enter the sight.
+**
+**  @param unit     Unit whose sight to move.
+**  @param old_pos  Old position of the unit.
+*/
+static void MapMoveUnitSight(CUnit &unit, const Vec2i &old_pos)
+{
+	Assert(unit.Container == nullptr);
+
+	MapMoveUnitSightRec(unit, old_pos, unit.tilePos, unit.Type->get_tile_width(), unit.Type->get_tile_height());
+
+	if (!unit.IsUnusable()) {
+		if (unit.Stats->Variables[RADAR_INDEX].Value) {
+			MapSightMove<MapUnmarkTileRadar, MapMarkTileRadar>(*unit.Player, old_pos, unit.tilePos, unit.Type->get_tile_width(), unit.Type->get_tile_height(), unit.Stats->Variables[RADAR_INDEX].Value, unit.MapLayer->ID);
+		}
+		if (unit.Stats->Variables[RADARJAMMER_INDEX].Value) {
+			MapSightMove<MapUnmarkTileRadarJammer, MapMarkTileRadarJammer>(*unit.Player, old_pos, unit.tilePos, unit.Type->get_tile_width(), unit.Type->get_tile_height(), unit.Stats->Variables[RADARJAMMER_INDEX].Value, unit.MapLayer->ID);
+		}
+	}
+}
+
 /**
 **  Update the Unit Current sight range to good value and transported units inside.
 **
@@ -3321,6 +3397,24 @@ void UpdateUnitSightRange(CUnit &unit)
 	}
 }
 
+/**
+**  Notify the pathfinder of changes to the tiles occupied by a unit, if the unit blocks movement by more than just occupying the tiles.
+**
+**  @param unit  unit whose field flags have changed.
+*/
+static void NotifyPathfinderOfUnitFieldFlags(const CUnit &unit)
+{
+	if ((unit.Type->FieldFlags & ~(tile_flag::land_unit | tile_flag::air_unit | tile_flag::sea_unit)) == tile_flag::none) {
+		return;
+	}
+
+	for (int x = 0; x < unit.Type->get_tile_width(); ++x) {
+		for (int y = 0; y < unit.Type->get_tile_height(); ++y) {
+			PathfinderTileChanged(unit.tilePos + Vec2i(x, y), unit.MapLayer->ID);
+		}
+	}
+}
+
 /**
 **  Mark the field with the FieldFlags.
 **
@@ -3348,6 +3442,8 @@ void MarkUnitFieldFlags(const CUnit &unit)
 		} while (--w);
 		index += unit.MapLayer->get_width();
 	} while (--h);
+
+	NotifyPathfinderOfUnitFieldFlags(unit);
 }
 
 class _UnmarkUnitFieldFlags
@@ -3396,6 +3492,8 @@ void UnmarkUnitFieldFlags(const CUnit &unit)
 		} while (--w);
 		index += unit.MapLayer->get_width();
 	} while (--h);
+
+	NotifyPathfinderOfUnitFieldFlags(unit);
 }
 
 /**
@@ -3417,6 +3515,8 @@ void CUnit::AddInContainer(CUnit &host)
 	}
 	host.UnitInside = this;
 	host.InsideCount++;
+	//the host may be able to attack with the unit inside it
+	host.wake_up();
 	//Wyrmgus start
 	if (!SaveGameLoading) { //if host has no range by itself, but the unit has range, and the unit can attack from a transporter, change the host's range to the unit's; but don't do this while loading, as it causes a crash (since one unit needs to be loaded before the other, and when this function is processed both won't already have their variables set)
 		host.UpdateContainerAttackRange();
@@ -3446,6 +3546,7 @@ static void RemoveUnitFromContainer(CUnit &unit)
 		}
 	}
 	unit.Container = nullptr;
+	host->wake_up();
 	//Wyrmgus start
 	//reset host attack range
 	host->UpdateContainerAttackRange();
@@ -3732,7 +3833,13 @@ static void UnitInXY(CUnit &unit, const Vec2i &pos, const int z)
 void CUnit::MoveToXY(const Vec2i &pos, int z)
 //Wyrmgus end
 {
-	MapUnmarkUnitSight(*this);
+	//for a step to an adjacent tile in the same map layer, only the tiles leaving or entering the unit's sight need to be updated; the tiles under the unit stay in sight, so its seen count is not affected by doing that after the move
+	const Vec2i old_pos = this->tilePos;
+	const bool move_sight = this->Container == nullptr && this->MapLayer->ID == z && abs(pos.x - old_pos.x) <= 1 && abs(pos.y - old_pos.y) <= 1;
+
+	if (!move_sight) {
+		MapUnmarkUnitSight(*this);
+	}
 	CMap::Map.Remove(*this);
 	UnmarkUnitFieldFlags(*this);
 
@@ -3750,7 +3857,11 @@ void CUnit::MoveToXY(const Vec2i &pos, int z)
 	MarkUnitFieldFlags(*this);
 	//  Recalculate the seen count.
 	UnitCountSeen(*this);
-	MapMarkUnitSight(*this);
+	if (move_sight) {
+		MapMoveUnitSight(*this, old_pos);
+	} else {
+		MapMarkUnitSight(*this);
+	}
 	
 	//Wyrmgus start
 	// if there is a trap in the new tile, trigger it
@@ -3778,6 +3889,8 @@ void CUnit::MoveToXY(const Vec2i &pos, int z)
 void CUnit::Place(const Vec2i &pos, int z)
 {
 	Assert(Removed);
+
+	this->wake_up();
 	
 	const CMapLayer *old_map_layer = this->MapLayer;
 
@@ -4081,6 +4194,8 @@ void CUnit::Remove(CUnit *host)
 		return;
 	}
 
+	this->wake_up();
+
 	if (this->Type->can_produce_a_resource()) {
 		const wyrmgus::tile *tile = this->get_center_tile();
 		if (tile->get_settlement() != nullptr) {
@@ -4557,10 +4672,46 @@ void UnitGoesOutOfFog(CUnit &unit, const CPlayer &player)
 	}
 }
 
+/**
+**  Get the players, out of a given set, which can see a unit, with each
+**  player being represented as one bit. This is the same as calling
+**  CUnit::IsVisible for each of the players.
+**
+**  @param unit         The unit to check.
+**  @param player_mask  The players to check.
+*/
+static uint64_t GetUnitVisiblePlayerMask(const CUnit &unit, const uint64_t player_mask)
+{
+	uint64_t seen_mask = 0;
+	for (int p = 0; p < PlayerMax; ++p) {
+		if (unit.VisCount[p]) {
+			seen_mask |= static_cast<uint64_t>(1) << p;
+		}
+	}
+
+	if (seen_mask == 0) {
+		return 0;
+	}
+
+	const uint64_t revealed_player_mask = CPlayer::get_revealed_player_mask();
+
+	uint64_t visible_mask = 0;
+	for (uint64_t remaining_mask = player_mask; remaining_mask != 0; remaining_mask &= remaining_mask - 1) {
+		const int p = std::countr_zero(remaining_mask);
+
+		if ((seen_mask & (CPlayer::Players[p]->get_team_vision_mask() | revealed_player_mask)) != 0) {
+			visible_mask |= static_cast<uint64_t>(1) << p;
+		}
+	}
+
+	return visible_mask;
+}
+
 /**
 **  Recalculates a units visiblity count. This happens really often,
 **  Like every time a unit moves. It's really fast though, since we
-**  have per-tile counts.
+**  have per-tile visibility masks, so the unit's tiles are only
+**  gone through once for all players.
 **
 **  @param unit  pointer to the unit to check if seen
 */
@@ -4568,72 +4719,76 @@ void UnitCountSeen(CUnit &unit)
 {
 	Assert(unit.Type);
 
-	// FIXME: optimize, only work on certain players?
-	// This is for instance good for updating shared vision...
-
-	//  Store old values in oldv[p]. This store if the player could see the
-	//  unit before this calc.
-	std::array<int, PlayerMax> oldv{};
+	//  Only players which are in the game are counted.
+	uint64_t active_player_mask = 0;
 	for (int p = 0; p < PlayerMax; ++p) {
 		if (CPlayer::Players[p]->Type != PlayerNobody) {
-			oldv[p] = unit.IsVisible(*CPlayer::Players[p]);
+			active_player_mask |= static_cast<uint64_t>(1) << p;
 		}
 	}
 
+	//  Store the players which could see the unit before this calc.
+	const uint64_t old_visible_mask = GetUnitVisiblePlayerMask(unit, active_player_mask);
+
 	//  Calculate new VisCount values.
 	const int height = unit.Type->get_tile_height();
 	const int width = unit.Type->get_tile_width();
 
-	for (int p = 0; p < PlayerMax; ++p) {
-		if (CPlayer::Players[p]->Type != PlayerNobody) {
-			int newv = 0;
-			int y = height;
-			unsigned int index = unit.Offset;
-			do {
-				wyrmgus::tile *mf = unit.MapLayer->Field(index);
-				int x = width;
-				do {
-					if (unit.Type->BoolFlag[PERMANENTCLOAK_INDEX].value && unit.Player != CPlayer::Players[p]) {
-						if (mf->player_info->VisCloak[p]) {
-							newv++;
-						}
-					//Wyrmgus start
-					} else if (unit.Type->BoolFlag[ETHEREAL_INDEX].value && unit.Player != CPlayer::Players[p]) {
-						if (mf->player_info->VisEthereal[p]) {
-							newv++;
-						}
-					//Wyrmgus end
-					} else {
-						if (mf->player_info->IsVisible(*CPlayer::Players[p])) {
-							newv++;
-						}
-					}
-					++mf;
-				} while (--x);
-				index += unit.MapLayer->get_width();
-			} while (--y);
-			unit.VisCount[p] = newv;
-		}
+	//  Players other than the owner see permanently cloaked or ethereal units only with detection.
+	const bool cloaked = unit.Type->BoolFlag[PERMANENTCLOAK_INDEX].value;
+	const bool ethereal = !cloaked && unit.Type->BoolFlag[ETHEREAL_INDEX].value;
+	const uint64_t owner_mask = static_cast<uint64_t>(1) << unit.Player->Index;
+	const uint64_t detecting_player_mask = (cloaked || ethereal) ? (active_player_mask & ~owner_mask) : 0;
+
+	for (uint64_t remaining_mask = active_player_mask; remaining_mask != 0; remaining_mask &= remaining_mask - 1) {
+		unit.VisCount[std::countr_zero(remaining_mask)] = 0;
 	}
 
+	int y = height;
+	unsigned int index = unit.Offset;
+	do {
+		wyrmgus::tile *mf = unit.MapLayer->Field(index);
+		int x = width;
+		do {
+			//  Without fog of war, explored tiles count as visible.
+			uint64_t tile_mask = CMap::Map.NoFogOfWar ? mf->player_info->get_explored_mask() : mf->player_info->get_visible_mask();
+			tile_mask &= active_player_mask & ~detecting_player_mask;
+
+			for (uint64_t remaining_mask = detecting_player_mask; remaining_mask != 0; remaining_mask &= remaining_mask - 1) {
+				const int p = std::countr_zero(remaining_mask);
+
+				if (cloaked ? mf->player_info->get_cloak_visibility(p) : mf->player_info->get_ethereal_visibility(p)) {
+					tile_mask |= static_cast<uint64_t>(1) << p;
+				}
+			}
+
+			for (; tile_mask != 0; tile_mask &= tile_mask - 1) {
+				++unit.VisCount[std::countr_zero(tile_mask)];
+			}
+
+			++mf;
+		} while (--x);
+		index += unit.MapLayer->get_width();
+	} while (--y);
+
 	//
 	// Now here comes the tricky part. We have to go in and out of fog
 	// for players. Hopefully this works with shared vision just great.
 	//
-	for (int p = 0; p < PlayerMax; ++p) {
-		if (CPlayer::Players[p]->Type != PlayerNobody) {
-			int newv = unit.IsVisible(*CPlayer::Players[p]);
-			if (!oldv[p] && newv) {
-				// Might have revealed a destroyed unit which caused it to
-				// be released
-				if (!unit.Type) {
-					break;
-				}
-				UnitGoesOutOfFog(unit, *CPlayer::Players[p]);
-			}
-			if (oldv[p] && !newv) {
-				UnitGoesUnderFog(unit, *CPlayer::Players[p]);
+	const uint64_t new_visible_mask = GetUnitVisiblePlayerMask(unit, active_player_mask);
+
+	for (uint64_t changed_mask = old_visible_mask ^ new_visible_mask; changed_mask != 0; changed_mask &= changed_mask - 1) {
+		const int p = std::countr_zero(changed_mask);
+
+		if ((new_visible_mask & (static_cast<uint64_t>(1) << p)) != 0) {
+			// Might have revealed a destroyed unit which caused it to
+			// be released
+			if (!unit.Type) {
+				break;
 			}
+			UnitGoesOutOfFog(unit, *CPlayer::Players[p]);
+		} else {
+			UnitGoesUnderFog(unit, *CPlayer::Players[p]);
 		}
 	}
 }
@@ -4792,6 +4947,8 @@ void CUnit::ChangeOwner(CPlayer &newplayer, bool show_change)
 		return;
 	}
 
+	this->wake_up();
+
 	// Rescue all units in buildings/transporters.
 	//Wyrmgus start
 //	CUnit *uins = UnitInside;
@@ -5615,6 +5772,38 @@ int CUnit::GetIndividualUpgrade(const CUpgrade *upgrade) const
 	}
 }
 
+void CUnit::update_increasing_variable(const int var_index)
+{
+	if (this->Variable[var_index].Increase == 0) {
+		return;
+	}
+
+	const auto find_iterator = std::lower_bound(this->increasing_variables.begin(), this->increasing_variables.end(), var_index);
+	if (find_iterator != this->increasing_variables.end() && *find_iterator == var_index) {
+		return;
+	}
+
+	this->increasing_variables.insert(find_iterator, var_index);
+}
+
+void CUnit::update_increasing_variables()
+{
+	this->increasing_variables.clear();
+
+	for (size_t i = 0; i < this->Variable.size(); ++i) {
+		if (this->Variable[i].Increase != 0) {
+			this->increasing_variables.push_back(static_cast<int>(i));
+		}
+	}
+}
+
+void CUnit::prune_increasing_variables()
+{
+	std::erase_if(this->increasing_variables, [this](const int var_index) {
+		return this->Variable[var_index].Increase == 0;
+	});
+}
+
 int CUnit::GetAvailableLevelUpUpgrades(bool only_units) const
 {
 	int value = 0;
@@ -6255,11 +6444,13 @@ bool CUnit::is_autocast_spell(const wyrmgus::spell *spell) const
 void CUnit::add_autocast_spell(const wyrmgus::spell *spell)
 {
 	this->autocast_spells.push_back(spell);
+	this->wake_up();
 }
 
 void CUnit::remove_autocast_spell(const wyrmgus::spell *spell)
 {
 	wyrmgus::vector::remove(this->autocast_spells, spell);
+	this->wake_up();
 }
 
 /**
@@ -7060,6 +7251,7 @@ void LetUnitDie(CUnit &unit, bool suicide)
 
 	// Not good: UnitUpdateHeading(unit);
 	unit.Orders[0] = COrder::NewActionDie();
+	unit.wake_up();
 	if (type->get_corpse_type() != nullptr) {
 #ifdef DYNAMIC_LOAD
 		if (!type->Sprite) {
@@ -7467,6 +7659,7 @@ void HitUnit_SpecialDamageEffect(CUnit &target, int dmg_var)
 	if (dmg_var == COLDDAMAGE_INDEX && target.Variable[COLDRESISTANCE_INDEX].Value < 100 && target.Type->BoolFlag[ORGANIC_INDEX].value) { //if resistance to cold is 100%, the effect has no chance of being applied
 		int rand_max = 100 * 100 / (100 - target.Variable[COLDRESISTANCE_INDEX].Value);
 		if (SyncRand(rand_max) == 0) {
+			target.wake_up();
 			target.Variable[SLOW_INDEX].Enable = 1;
 			target.Variable[SLOW_INDEX].Value = std::max(200, target.Variable[SLOW_INDEX].Value);
 			target.Variable[SLOW_INDEX].Max = 1000;
@@ -7474,6 +7667,7 @@ void HitUnit_SpecialDamageEffect(CUnit &target, int dmg_var)
 	} else if (dmg_var == LIGHTNINGDAMAGE_INDEX && target.Variable[LIGHTNINGRESISTANCE_INDEX].Value < 100 && target.Type->BoolFlag[ORGANIC_INDEX].value) {
 		int rand_max = 100 * 100 / (100 - target.Variable[LIGHTNINGRESISTANCE_INDEX].Value);
 		if (SyncRand(rand_max) == 0) {
+			target.wake_up();
 			target.Variable[STUN_INDEX].Enable = 1;
 			target.Variable[STUN_INDEX].Value = std::max(50, target.Variable[STUN_INDEX].Value);
 			target.Variable[STUN_INDEX].Max = 1000;
@@ -7590,6 +7784,8 @@ void HitUnit(CUnit *attacker, CUnit &target, int damage, const Missile *missile,
 		return;
 	}
 
+	target.wake_up();
+
 	Assert(damage != 0 && target.CurrentAction() != UnitAction::Die && !target.Type->BoolFlag[VANISHES_INDEX].value);
 
 	//Wyrmgus start
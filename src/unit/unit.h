@@ -503,6 +503,32 @@ public:
 		return this->Variable[var_index].Increase;
 	}
 
+	void set_variable_increase(const int var_index, const int increase)
+	{
+		this->Variable[var_index].Increase = static_cast<char>(increase);
+		this->update_increasing_variable(var_index);
+	}
+
+	void change_variable_increase(const int var_index, const int change)
+	{
+		this->set_variable_increase(var_index, this->get_variable_increase(var_index) + change);
+	}
+
+	//get the indices of the variables which may have a non-zero increase, in ascending order; variables whose increase has become zero stay in the list until it is pruned
+	const std::vector<int> &get_increasing_variables() const
+	{
+		return this->increasing_variables;
+	}
+
+	//add a variable to the list of increasing ones if its increase is non-zero; this must be called whenever the increase of a variable is changed without the setter
+	void update_increasing_variable(const int var_index);
+
+	//rebuild the list of increasing variables, e.g. after the variables have been replaced
+	void update_increasing_variables();
+
+	//remove the variables whose increase is zero from the list of increasing ones
+	void prune_increasing_variables();
+
 	int GetModifiedVariable(const int index, const VariableAttribute variable_type) const;
 	int GetModifiedVariable(const int index) const;
 
@@ -653,6 +679,22 @@ public:
 		this->step_count = 0;
 	}
 
+	unsigned long get_wake_cycle() const
+	{
+		return this->wake_cycle;
+	}
+
+	//put the unit to sleep until the given game cycle, i.e. have its actions skip the handling of its buffs and the full execution of its order until then
+	void sleep_until(const unsigned long cycle)
+	{
+		this->wake_cycle = cycle;
+	}
+
+	void wake_up()
+	{
+		this->wake_cycle = 0;
+	}
+
 public:
 	class CUnitManagerData final
 	{
@@ -772,7 +814,6 @@ public:
 	unsigned UnderConstruction : 1;    /// Unit is in construction
 	unsigned Active : 1;         /// Unit is active for AI
 	unsigned Boarded : 1;        /// Unit is on board a transporter.
-	unsigned CacheLock : 1;      /// Unit is on lock by unitcache operations.
 
 	unsigned Summoned : 1;       /// Unit is summoned using spells.
 	unsigned Waiting : 1;        /// Unit is waiting and playing its still animation
@@ -796,6 +837,9 @@ public:
 	} Seen;
 
 	std::vector<wyrmgus::unit_variable> Variable; /// array of User Defined variables.
+private:
+	std::vector<int> increasing_variables; /// the indices of the variables which may have a non-zero increase
+public:
 
 	unsigned long TTL;  /// time to live
 
@@ -807,6 +851,7 @@ public:
 	
 private:
 	unsigned char step_count = 0;	/// How many steps the unit has taken without stopping (maximum 10)
+	unsigned long wake_cycle = 0;	/// The game cycle until which the unit is asleep
 	int best_contained_unit_attack_range = 0;
 
 public:
@@ -36,8 +36,10 @@
 
 #include "map/map.h"
 #include "map/map_layer.h"
+#include "map/resource_index.h"
 #include "map/tile.h"
 #include "unit/unit.h"
+#include "unit/unit_grid.h"
 #include "unit/unit_type.h"
 
 /**
@@ -62,6 +64,9 @@ void CMap::Insert(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < unit.MapLayer->get_width());
 		index += unit.MapLayer->get_width();
 	} while (--i && unit.tilePos.y + (i - h) < unit.MapLayer->get_height());
+
+	unit.MapLayer->get_unit_grid()->insert(&unit);
+	unit.MapLayer->get_resource_index()->insert_unit(&unit);
 }
 
 /**
@@ -86,6 +91,9 @@ void CMap::Remove(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < unit.MapLayer->get_width());
 		index += unit.MapLayer->get_width();
 	} while (--i && unit.tilePos.y + (i - h) < unit.MapLayer->get_height());
+
+	unit.MapLayer->get_unit_grid()->remove(&unit);
+	unit.MapLayer->get_resource_index()->remove_unit(&unit);
 }
 
 //Wyrmgus start
@@ -34,10 +34,13 @@
 #include "economy/resource.h"
 #include "map/map.h"
 #include "map/map_layer.h"
+#include "map/resource_index.h"
 #include "map/tile.h"
 #include "map/tile_flag.h"
 #include "missile.h"
 #include "pathfinder.h"
+#include "pathfinder/connectivity.h"
+#include "pathfinder/deposit_distance_field.h"
 #include "player.h"
 #include "script.h"
 #include "spell/spell.h"
@@ -47,6 +50,7 @@
 #include "unit/unit_type.h"
 #include "unit/unit_type_type.h"
 #include "util/log_util.h"
+#include "util/point_util.h"
 #include "util/vector_util.h"
 
 /*----------------------------------------------------------------------------
@@ -188,9 +192,45 @@ bool FindTerrainType(const tile_flag movemask, const wyrmgus::resource *resource
 					 const CPlayer &player, const Vec2i &startPos, Vec2i *terrainPos, int z, const landmass *landmass)
 					 //Wyrmgus end
 {
+	//go through the tiles of the resource in order of distance instead of flood-filling the terrain around the start position
+	//without knowledge of unseen terrain, the connectivity can't be used for human players, as it would leak information about unexplored tiles, so then the terrain is flood-filled through explored tiles instead
+	if (resource != nullptr && (AStarKnowUnseenTerrain || player.AiEnabled)) {
+		const tile_flag terrain_movemask = movemask & ~(tile_flag::land_unit | tile_flag::air_unit | tile_flag::sea_unit);
+		QPoint resource_pos;
+
+		const bool found = CMap::Map.MapLayers[z]->get_resource_index()->find_resource_tile(startPos, range, resource, [&](const QPoint &tile_pos) {
+			const wyrmgus::tile *tile = CMap::Map.Field(tile_pos, z);
+
+			if (!tile->player_info->IsTeamExplored(player)) {
+				return false;
+			}
+
+			if (tile->get_owner() != nullptr && tile->get_owner() != &player && !tile->get_owner()->has_neutral_faction_type() && !player.has_neutral_faction_type()) {
+				return false;
+			}
+
+			if (landmass != nullptr && CMap::Map.get_tile_landmass(tile_pos, z) != landmass) {
+				return false;
+			}
+
+			if (tile_pos != startPos && !wyrmgus::connectivity::get()->can_reach(startPos, QRect(tile_pos - QPoint(1, 1), QSize(3, 3)), terrain_movemask, z)) {
+				return false;
+			}
+
+			return true;
+		}, resource_pos);
+
+		if (found && terrainPos != nullptr) {
+			*terrainPos = resource_pos;
+		}
+
+		return found;
+	}
+
 	TerrainTraversal terrainTraversal;
 
 	terrainTraversal.SetSize(CMap::Map.Info.MapWidths[z], CMap::Map.Info.MapHeights[z]);
+	terrainTraversal.set_bounds(QRect(startPos, QSize(1, 1)), range);
 	terrainTraversal.Init();
 
 	terrainTraversal.PushPos(startPos);
@@ -478,6 +518,7 @@ public:
 	explicit ResourceUnitFinder(const CUnit &worker, const CUnit *deposit, const resource *resource, int maxRange, bool check_usage, CUnit **resultMine, bool only_harvestable, bool ignore_exploration, bool only_unsettled_area, bool include_luxury, bool only_same) :
 	//Wyrmgus end
 		worker(worker),
+		resource(resource),
 		res_info(worker.Type->get_resource_info(resource)),
 		deposit(deposit),
 		movemask(worker.Type->MovementMask),
@@ -498,8 +539,12 @@ public:
 		*resultMine = nullptr;
 	}
 	VisitResult Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from);
+	void FindInIndex(const CUnit &start_unit, const QPoint &start_pos);
 private:
+	bool IsResourceSought(const wyrmgus::resource *resource) const;
 	bool MineIsUsable(const CUnit &mine) const;
+	bool IsTileBlocked(const wyrmgus::tile &tile, const CUnit *mine) const;
+	bool CheckMine(CUnit *mine, const wyrmgus::tile &tile);
 
 	struct ResourceUnitFinder_Cost {
 	public:
@@ -528,6 +573,7 @@ private:
 
 private:
 	const CUnit &worker;
+	const wyrmgus::resource *resource = nullptr;
 	const resource_info *res_info = nullptr;
 	const CUnit *deposit;
 	tile_flag movemask;
@@ -603,29 +649,27 @@ void ResourceUnitFinder::ResourceUnitFinder_Cost::SetFrom(const CUnit &mine, con
 	}
 }
 
-VisitResult ResourceUnitFinder::Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from)
+bool ResourceUnitFinder::IsResourceSought(const wyrmgus::resource *resource) const
 {
-	Q_UNUSED(from)
-
-	const wyrmgus::tile *tile = worker.MapLayer->Field(pos);
+	//whether units giving the resource can match the resource finder
+	return resource == this->resource || (!only_same && resource->get_index() != TradeCost && resource->get_final_resource() == this->resource) || (include_luxury && resource->LuxuryResource);
+}
 
-	//Wyrmgus start
-//	if (!worker.Player->AiEnabled && !tile->player_info->IsExplored(*worker.Player)) {
-	if (!tile->player_info->IsTeamExplored(*worker.Player) && !ignore_exploration) {
-	//Wyrmgus end
-		return VisitResult::DeadEnd;
-	}
+bool ResourceUnitFinder::IsTileBlocked(const wyrmgus::tile &tile, const CUnit *mine) const
+{
+	const CPlayer *tile_owner = tile.get_owner();
 
-	//Wyrmgus start
-//	CUnit *mine = tile->UnitCache.find(res_finder);
-	CUnit *mine = tile->UnitCache.find(res_finder);
+	return tile_owner != nullptr && tile_owner != worker.Player && !tile_owner->has_neutral_faction_type() && !worker.Player->has_neutral_faction_type() && (mine == nullptr || mine->Type->get_given_resource() == nullptr || mine->Type->get_given_resource()->get_index() != TradeCost);
+}
 
-	const CPlayer *tile_owner = tile->get_owner();
-	
-	if (tile_owner != nullptr && tile_owner != worker.Player && !tile_owner->has_neutral_faction_type() && !worker.Player->has_neutral_faction_type() && (mine == nullptr || mine->Type->get_given_resource() == nullptr || mine->Type->get_given_resource()->get_index() != TradeCost)) {
-		return VisitResult::DeadEnd;
-	}
-	//Wyrmgus end
+/**
+**  Check a resource unit found on a tile.
+**
+**  @return  True if the resource unit is the best possible one, so that the search can stop.
+*/
+bool ResourceUnitFinder::CheckMine(CUnit *mine, const wyrmgus::tile &tile)
+{
+	const CPlayer *tile_owner = tile.get_owner();
 
 	//Wyrmgus start
 //	if (mine && mine != *resultMine && MineIsUsable(*mine)) {
@@ -644,12 +688,41 @@ VisitResult ResourceUnitFinder::Visit(TerrainTraversal &terrainTraversal, const
 			*resultMine = mine;
 
 			if (cost.IsMin()) {
-				return VisitResult::Finished;
+				return true;
 			}
 			bestCost = cost;
 		}
 	}
 
+	return false;
+}
+
+VisitResult ResourceUnitFinder::Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from)
+{
+	Q_UNUSED(from)
+
+	const wyrmgus::tile *tile = worker.MapLayer->Field(pos);
+
+	//Wyrmgus start
+//	if (!worker.Player->AiEnabled && !tile->player_info->IsExplored(*worker.Player)) {
+	if (!tile->player_info->IsTeamExplored(*worker.Player) && !ignore_exploration) {
+	//Wyrmgus end
+		return VisitResult::DeadEnd;
+	}
+
+	//Wyrmgus start
+//	CUnit *mine = tile->UnitCache.find(res_finder);
+	CUnit *mine = tile->UnitCache.find(res_finder);
+
+	if (this->IsTileBlocked(*tile, mine)) {
+		return VisitResult::DeadEnd;
+	}
+	//Wyrmgus end
+
+	if (this->CheckMine(mine, *tile)) {
+		return VisitResult::Finished;
+	}
+
 	if (CanMoveToMask(pos, movemask, worker.MapLayer->ID)) { // reachable
 		if (terrainTraversal.Get(pos) < maxRange) {
 			return VisitResult::Ok;
@@ -661,6 +734,99 @@ VisitResult ResourceUnitFinder::Visit(TerrainTraversal &terrainTraversal, const
 	}
 }
 
+/**
+**  Go through the resource units of the map layer's resource index, instead of flood-filling the terrain around the start unit.
+**
+**  The resource units in range are checked in order of their distance to the start unit, and their reachability is checked with the map layer's connectivity.
+**
+**  @param start_unit          The unit around which to search.
+**  @param start_pos           A passable position at the start unit, from which reachability is checked.
+*/
+void ResourceUnitFinder::FindInIndex(const CUnit &start_unit, const QPoint &start_pos)
+{
+	const CUnit *first_container = start_unit.GetFirstContainer();
+	const QRect start_rect = first_container->get_tile_rect();
+	const CMapLayer *map_layer = worker.MapLayer;
+	const QRect map_rect(QPoint(0, 0), map_layer->get_size());
+
+	//the candidates are keyed by their distance, and then by their position and unit number, so that the order in which they are checked doesn't depend on the order of the index
+	std::vector<std::tuple<int, int, int, CUnit *>> candidates;
+
+	for (const wyrmgus::resource *candidate_resource : wyrmgus::resource::get_all()) {
+		if (!this->IsResourceSought(candidate_resource)) {
+			continue;
+		}
+
+		for (CUnit *mine : map_layer->get_resource_index()->get_resource_units(candidate_resource)) {
+			const QRect mine_rect = mine->get_tile_rect();
+			const int dx = std::max({ mine_rect.left() - start_rect.right(), 0, start_rect.left() - mine_rect.right() });
+			const int dy = std::max({ mine_rect.top() - start_rect.bottom(), 0, start_rect.top() - mine_rect.bottom() });
+			const int distance = std::max(dx, dy);
+
+			if (distance > maxRange) {
+				continue;
+			}
+
+			candidates.emplace_back(distance, point::to_index(mine->tilePos, map_layer->get_width()), UnitNumber(*mine), mine);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	for (const auto &[distance, tile_index, unit_number, mine] : candidates) {
+		if (!res_finder(mine)) {
+			continue;
+		}
+
+		//the first tile of the resource unit on which it would have been found by going through the terrain
+		const wyrmgus::tile *mine_tile = nullptr;
+		const QRect mine_rect = mine->get_tile_rect().intersected(map_rect);
+
+		for (int y = mine_rect.top(); y <= mine_rect.bottom() && mine_tile == nullptr; ++y) {
+			for (int x = mine_rect.left(); x <= mine_rect.right(); ++x) {
+				const wyrmgus::tile *tile = map_layer->Field(x, y);
+
+				if ((tile->player_info->IsTeamExplored(*worker.Player) || ignore_exploration) && !this->IsTileBlocked(*tile, mine)) {
+					mine_tile = tile;
+					break;
+				}
+			}
+		}
+
+		if (mine_tile == nullptr) {
+			continue;
+		}
+
+		if (!wyrmgus::connectivity::get()->can_reach(start_pos, mine_rect.adjusted(-1, -1, 1, 1), movemask, map_layer->ID)) {
+			continue;
+		}
+
+		if (this->CheckMine(mine, *mine_tile)) {
+			return;
+		}
+	}
+}
+
+/**
+**  Get a passable position at a unit, from which a search around it would begin.
+*/
+static QPoint GetResourceSearchStartPos(const CUnit &start_unit, const tile_flag movemask)
+{
+	const CUnit *first_container = start_unit.GetFirstContainer();
+	const CMapLayer *map_layer = first_container->MapLayer;
+	const QRect rect = first_container->get_tile_rect().adjusted(-1, -1, 1, 1).intersected(QRect(QPoint(0, 0), map_layer->get_size()));
+
+	for (int y = rect.top(); y <= rect.bottom(); ++y) {
+		for (int x = rect.left(); x <= rect.right(); ++x) {
+			if (map_layer->Field(x, y)->is_passable_ignoring_mobile_units(movemask)) {
+				return QPoint(x, y);
+			}
+		}
+	}
+
+	return first_container->tilePos;
+}
+
 /**
 **  Find Resource.
 **
@@ -684,11 +850,26 @@ CUnit *UnitFindResource(const CUnit &unit, const CUnit &start_unit, const int ra
 		depot = FindDepositNearLoc(*unit.Player, start_unit.tilePos, range, resource, start_unit.MapLayer->ID);
 	}
 
+	CUnit *resultMine = nullptr;
+
+	//Wyrmgus start
+//	ResourceUnitFinder resourceUnitFinder(unit, depot, resource, range, check_usage, &resultMine);
+	ResourceUnitFinder resourceUnitFinder(unit, depot, resource, range, check_usage, &resultMine, only_harvestable, ignore_exploration, only_unsettled_area, include_luxury, only_same);
+	//Wyrmgus end
+
+	//units bound to rails can't move diagonally, so the distances of the resource index don't apply to them
+	//without knowledge of unseen terrain, the connectivity can't be used for human players, as it would leak information about unexplored tiles, so then the terrain is flood-filled through explored tiles instead
+	if (!unit.Type->BoolFlag[RAIL_INDEX].value && (AStarKnowUnseenTerrain || unit.Player->AiEnabled)) {
+		resourceUnitFinder.FindInIndex(start_unit, GetResourceSearchStartPos(start_unit, unit.Type->MovementMask));
+		return resultMine;
+	}
+
 	TerrainTraversal terrainTraversal;
 
 	//Wyrmgus start
 //	terrainTraversal.SetSize(Map.Info.MapWidth, Map.Info.MapHeight);
 	terrainTraversal.SetSize(start_unit.MapLayer->get_width(), start_unit.MapLayer->get_height());
+	terrainTraversal.set_bounds(start_unit.GetFirstContainer()->get_tile_rect(), range);
 	if (unit.Type->BoolFlag[RAIL_INDEX].value) {
 		terrainTraversal.SetDiagonalAllowed(false);
 	}
@@ -701,17 +882,59 @@ CUnit *UnitFindResource(const CUnit &unit, const CUnit &start_unit, const int ra
 		terrainTraversal.PushUnitPosAndNeighbor(start_unit);
 	}
 
-	CUnit *resultMine = nullptr;
-
-	//Wyrmgus start
-//	ResourceUnitFinder resourceUnitFinder(unit, depot, resource, range, check_usage, &resultMine);
-	ResourceUnitFinder resourceUnitFinder(unit, depot, resource, range, check_usage, &resultMine, only_harvestable, ignore_exploration, only_unsettled_area, include_luxury, only_same);
-	//Wyrmgus end
-
 	terrainTraversal.Run(resourceUnitFinder);
 	return resultMine;
 }
 
+/**
+**  Find the nearest deposit for a resource by reading the deposit distance field of the worker's player
+**
+**  @param unit        The unit that wants to find a deposit.
+**  @param range       Maximum distance to the depot.
+**  @param resource    Resource to find deposit from.
+**  @param deposits    The deposits of the unit's player and of its mutual allies.
+**
+**  @return            null if no deposit is reachable within range, or the deposit unit
+*/
+static CUnit *FindDepositInDistanceField(const CUnit &unit, const int range, const resource *resource, const std::vector<CUnit *> &deposits)
+{
+	const CUnit *first_container = unit.GetFirstContainer();
+
+	if (first_container->MapLayer == nullptr) {
+		return nullptr;
+	}
+
+	const int z = first_container->MapLayer->ID;
+
+	std::vector<CUnit *> valid_deposits;
+	for (CUnit *deposit : deposits) {
+		if (deposit->IsAliveOnMap() && deposit->CurrentAction() != UnitAction::Built && deposit->MapLayer == first_container->MapLayer && unit.can_return_goods_to(deposit, resource)) {
+			valid_deposits.push_back(deposit);
+		}
+	}
+
+	//sort the deposits so that the field doesn't consider them changed if they are gathered in a different order
+	std::sort(valid_deposits.begin(), valid_deposits.end(), [](const CUnit *lhs, const CUnit *rhs) {
+		return UnitNumber(*lhs) < UnitNumber(*rhs);
+	});
+	valid_deposits.erase(std::unique(valid_deposits.begin(), valid_deposits.end()), valid_deposits.end());
+
+	deposit_distance_field_key key;
+	key.player_index = unit.Player->get_index();
+	key.resource_index = resource->get_index();
+	key.z = z;
+	key.movement_mask = unit.Type->MovementMask;
+
+	deposit_distance_field *field = deposit_distance_field_cache::get()->get_field(key, valid_deposits);
+	CUnit *depot = field->get_nearest_deposit(unit);
+
+	if (depot == nullptr || first_container->MapDistanceTo(*depot) > range) {
+		return nullptr;
+	}
+
+	return depot;
+}
+
 /**
 **  Find "deposit". This will find a depot for a resource
 **
@@ -744,6 +967,15 @@ CUnit *FindDeposit(const CUnit &unit, const int range, const resource *resource)
 			}
 		}
 	}
+
+	//trade has its own rules for which deposits goods can be returned to, and human players' workers shouldn't learn about unexplored terrain from the field
+	if (resource != nullptr && resource->get_index() != TradeCost && (AStarKnowUnseenTerrain || unit.Player->AiEnabled)) {
+		CUnit *depot = FindDepositInDistanceField(unit, range, resource, table);
+		if (depot != nullptr) {
+			return depot;
+		}
+	}
+
 	return finder.Find(table.begin(), table.end());
 }
 
@@ -1016,24 +1248,62 @@ public:
 	}
 
 private:
+	/**
+	**  Find the unit with the lowest cost, picking the first one if several have the same cost.
+	**
+	**  The cost of a unit can be calculated cheaply, except for the obstacle and reachability
+	**  checks, which can only make it infinite. So the costs are calculated without those checks
+	**  first, and the units then checked in order of cost, stopping at the first which passes.
+	*/
 	template <typename Iterator>
 	CUnit *Find(Iterator begin, Iterator end) const
 	{
-		CUnit *enemy = nullptr;
-		int best_cost = INT_MAX;
+		//the cost, position and distance of each unit which may be a target
+		std::vector<std::tuple<int, int, int>> candidates;
 
-		for (Iterator it = begin; it != end; ++it) {
-			const int cost = ComputeCost(*it);
+		int position = 0;
+		for (Iterator it = begin; it != end; ++it, ++position) {
+			int distance = 0;
+			const int cost = ComputeCost(*it, distance);
+
+			if (cost < INT_MAX) {
+				candidates.emplace_back(cost, position, distance);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+
+		for (const auto &[cost, candidate_position, distance] : candidates) {
+			CUnit *dest = *std::next(begin, candidate_position);
 
-			if (cost < best_cost) {
-				enemy = *it;
-				best_cost = cost;
+			if (IsReachable(dest, distance)) {
+				return dest;
 			}
 		}
-		return enemy;
+
+		return nullptr;
 	}
 
-	int ComputeCost(CUnit *const dest) const
+	//check whether the attacker can reach the unit, which is the expensive part of the cost calculation
+	bool IsReachable(CUnit *const dest, const int d) const
+	{
+		const int attackrange = attacker->get_best_attack_range();
+
+		//Wyrmgus start
+		if (attackrange > 1 && !CheckObstaclesBetweenTiles(attacker->tilePos, dest->tilePos, tile_flag::air_impassable, attacker->MapLayer->ID)) {
+			return false;
+		}
+		//Wyrmgus end
+
+		if (d > attackrange && !UnitReachable(*attacker, *dest, attackrange, attacker->GetReactionRange() * 8)) {
+			return false;
+		}
+
+		return true;
+	}
+
+	//calculate the cost of attacking a unit, without checking whether it can be reached
+	int ComputeCost(CUnit *const dest, int &d) const
 	{
 		const CPlayer &player = *attacker->Player;
 		const wyrmgus::unit_type &type = *attacker->Type;
@@ -1057,18 +1327,7 @@ private:
 			return INT_MAX;
 		}
 
-		//Wyrmgus start
-		if (attackrange > 1 && !CheckObstaclesBetweenTiles(attacker->tilePos, dest->tilePos, tile_flag::air_impassable, attacker->MapLayer->ID)) {
-			return INT_MAX;
-		}
-		//Wyrmgus end
-		
-		// Unit in range ?
-		const int d = attacker->MapDistanceTo(*dest);
-
-		if (d > attackrange && !UnitReachable(*attacker, *dest, attackrange, attacker->GetReactionRange() * 8)) {
-			return INT_MAX;
-		}
+		d = attacker->MapDistanceTo(*dest);
 
 		// Attack walls only if we are stuck in them
 		if (dtype.BoolFlag[WALL_INDEX].value && d > 1) {
@@ -1161,13 +1420,13 @@ public:
 	public:
 		//Wyrmgus start
 //		FillBadGood(const CUnit &a, int r, std::vector<int> *g, std::vector<int> *b, int s):
-		explicit FillBadGood(const CUnit &a, int r, std::vector<int> &g, std::vector<int> &b, const int s, const bool i_n):
+		explicit FillBadGood(const CUnit &a, int r, std::vector<int> &g, std::vector<int> &b, const int s, const bool i_n, std::set<const CUnit *> &skipped_units):
 		//Wyrmgus end
 			attacker(&a), range(r), size(s),
 			//Wyrmgus start
 			include_neutral(i_n),
 			//Wyrmgus end
-			good(g), bad(b)
+			good(g), bad(b), skipped_units(skipped_units)
 		{
 		}
 
@@ -1191,7 +1450,7 @@ public:
 			const CPlayer &player = *attacker->Player;
 
 			if (!dest->IsVisibleAsGoal(player)) {
-				dest->CacheLock = 1;
+				this->skipped_units.insert(dest);
 				return;
 			}
 
@@ -1199,12 +1458,12 @@ public:
 			const wyrmgus::unit_type &dtype = *dest->Type;
 			// won't be a target...
 			if (!CanTarget(type, dtype)) { // can't be attacked.
-				dest->CacheLock = 1;
+				this->skipped_units.insert(dest);
 				return;
 			}
 			// Don't attack invulnerable units
 			if (dtype.BoolFlag[INDESTRUCTIBLE_INDEX].value || dest->Variable[UNHOLYARMOR_INDEX].Value) {
-				dest->CacheLock = 1;
+				this->skipped_units.insert(dest);
 				return;
 			}
 
@@ -1226,7 +1485,7 @@ public:
 				&& (!include_neutral || attacker->IsAllied(*dest) || dest->Player->Type == PlayerNeutral || attacker->Player->Index == dest->Player->Index)
 			) {
 			//Wyrmgus end
-				dest->CacheLock = 1;
+				this->skipped_units.insert(dest);
 
 				// Calc a negative cost
 				// The gost is more important when the unit would be killed
@@ -1299,11 +1558,11 @@ public:
 				//Wyrmgus end
 					++enemy_count;
 				} else {
-					dest->CacheLock = 1;
+					this->skipped_units.insert(dest);
 				}
 				// Attack walls only if we are stuck in them
 				if (dtype.BoolFlag[WALL_INDEX].value && d > 1) {
-					dest->CacheLock = 1;
+					this->skipped_units.insert(dest);
 				}
 			}
 
@@ -1343,13 +1602,14 @@ public:
 		//Wyrmgus start
 		const bool include_neutral;
 		//Wyrmgus end
+		std::set<const CUnit *> &skipped_units; //units which won't be chosen as targets
 	};
 
 	CUnit *Find(std::vector<CUnit *> &table)
 	{
 		//Wyrmgus start
 //		FillBadGood(*attacker, range, good, bad, size).Fill(table.begin(), table.end());
-		FillBadGood(*attacker, range, good, bad, size, include_neutral).Fill(table.begin(), table.end());
+		FillBadGood(*attacker, range, good, bad, size, include_neutral, skipped_units).Fill(table.begin(), table.end());
 		//Wyrmgus end
 		return Find(table.begin(), table.end());
 
@@ -1359,7 +1619,7 @@ public:
 	{
 		//Wyrmgus start
 //		FillBadGood(*attacker, range, good, bad, size).Fill(cache);
-		FillBadGood(*attacker, range, good, bad, size, include_neutral).Fill(cache);
+		FillBadGood(*attacker, range, good, bad, size, include_neutral, skipped_units).Fill(cache);
 		//Wyrmgus end
 		return Find(cache.begin(), cache.end());
 	}
@@ -1376,8 +1636,7 @@ private:
 
 	void Compute(CUnit *const dest)
 	{
-		if (dest->CacheLock) {
-			dest->CacheLock = 0;
+		if (this->skipped_units.contains(dest)) {
 			return;
 		}
 		const wyrmgus::unit_type &type = *attacker->Type;
@@ -1447,6 +1706,7 @@ private:
 	//Wyrmgus start
 	const bool include_neutral = false;
 	//Wyrmgus end
+	std::set<const CUnit *> skipped_units; //units found by FillBadGood not to be possible targets
 };
 
 struct CompareUnitDistance {
@@ -1569,7 +1829,9 @@ CUnit *AttackUnitsInDistance(const CUnit &unit, const int range, CUnitFilter pre
 		const CUnit *firstContainer = unit.GetFirstContainer();
 		std::vector<CUnit *> table;
 
+		//with no splash damage on allies to take into account, only the units of potential enemies need to be selected
 		SelectAroundUnit<circle>(*firstContainer, range, table,
+			unit.Player->get_potential_enemy_owner_mask(),
 			//Wyrmgus start
 //			MakeAndPredicate(HasNotSamePlayerAs(*CPlayer::Players[PlayerNumNeutral]), pred));
 			pred);
@@ -34,8 +34,10 @@
 #include "pathfinder.h"
 #include "unit/unit.h"
 #include "unit/unit_cache.h"
+#include "unit/unit_grid.h"
+#include "unit/unit_query_marker.h"
 #include "unit/unit_type.h"
-#include "util/fractional_int.h"
+#include "util/circle_util.h"
 
 class CPlayer;
 class CUnit;
@@ -334,54 +336,131 @@ private:
 	int z = 0;
 };
 
+//all players, for selecting units regardless of their owner
+constexpr uint64_t AllPlayersMask = ~static_cast<uint64_t>(0);
+
+/**
+**  Select the units in an area for which a predicate is true.
+**
+**  @param owner_mask  Only units owned by the players of this mask, with each player being represented as one bit, are considered; filtering the units by owner this way skips the units of other players in the unit grid buckets before the predicate is applied.
+*/
 template <bool circle, typename Pred>
 //Wyrmgus start
 //inline void SelectFixed(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, Pred pred)
-inline void SelectFixed(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, const int z, Pred pred)
+inline void SelectFixed(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, const int z, const uint64_t owner_mask, Pred pred)
 //Wyrmgus end
 {
 	Assert(CMap::Map.Info.IsPointOnMap(ltPos, z));
 	Assert(CMap::Map.Info.IsPointOnMap(rbPos, z));
 	Assert(units.empty());
 	
-	wyrmgus::decimillesimal_int middle_x;
-	wyrmgus::decimillesimal_int middle_y;
-	wyrmgus::decimillesimal_int radius;
+	//for a circle, the center and radius are in quarters of a tile, as the center may be between tiles, and the radius is the average of the half-widths and half-heights of the area
+	int center_x4 = 0;
+	int center_y4 = 0;
+	int radius4 = 0;
+	const std::vector<int> *row_half_widths = nullptr;
 
 	if constexpr (circle) {
-		middle_x = wyrmgus::decimillesimal_int(rbPos.x + ltPos.x) / 2;
-		middle_y = wyrmgus::decimillesimal_int(rbPos.y + ltPos.y) / 2;
-		radius = ((middle_x - ltPos.x) + (middle_y - ltPos.y)) / 2;
+		center_x4 = (rbPos.x + ltPos.x) * 2;
+		center_y4 = (rbPos.y + ltPos.y) * 2;
+		radius4 = (rbPos.x - ltPos.x) + (rbPos.y - ltPos.y);
+		row_half_widths = &wyrmgus::circle::get_row_half_widths(radius4 * radius4);
 	}
 
-	for (Vec2i posIt = ltPos; posIt.y != rbPos.y + 1; ++posIt.y) {
-		for (posIt.x = ltPos.x; posIt.x != rbPos.x + 1; ++posIt.x) {
-			if constexpr (circle) {
-				const wyrmgus::decimillesimal_int rel_x = posIt.x - middle_x;
-				const wyrmgus::decimillesimal_int rel_y = posIt.y - middle_y;
-				const wyrmgus::decimillesimal_int my = radius * radius - rel_x * rel_x;
-				if ((rel_y * rel_y) > my) {
-					continue;
-				}
+	//get the range of x positions in the area for a row, with the minimum being greater than the maximum if the row has no tiles in it
+	const auto get_row_span = [&](const int y) -> std::pair<int, int> {
+		if constexpr (circle) {
+			const int dy4 = std::abs(y * 4 - center_y4);
+
+			if (dy4 >= static_cast<int>(row_half_widths->size())) {
+				return { ltPos.x, ltPos.x - 1 };
+			}
+
+			const int half_width4 = (*row_half_widths)[dy4];
+
+			//the numerator of the minimum is only negative if the minimum is below zero, in which case it is clamped anyway
+			return { std::max<int>(ltPos.x, (center_x4 - half_width4 + 3) / 4), std::min<int>(rbPos.x, (center_x4 + half_width4) / 4) };
+		} else {
+			Q_UNUSED(y)
+			return { ltPos.x, rbPos.x };
+		}
+	};
+
+	const CMapLayer *map_layer = CMap::Map.MapLayers[z].get();
+	wyrmgus::unit_query_marker marker;
+	const QRect area_rect(QPoint(ltPos.x, ltPos.y), QPoint(rbPos.x, rbPos.y));
+
+	if (area_rect.width() * area_rect.height() >= wyrmgus::unit_grid::min_query_area) {
+		//go through the units of the buckets overlapping the area instead of through the unit cache of every tile
+		//to give the same result as going through the tiles would, each unit is keyed by the first of its tiles in the area, and by its position in the unit cache of that tile
+		std::vector<std::tuple<int, int, CUnit *>> keyed_units;
+
+		const wyrmgus::unit_grid *unit_grid = map_layer->get_unit_grid();
+		const QRect bucket_rect = unit_grid->get_bucket_rect(area_rect);
+
+		for (int bucket_y = bucket_rect.top(); bucket_y <= bucket_rect.bottom(); ++bucket_y) {
+			for (int bucket_x = bucket_rect.left(); bucket_x <= bucket_rect.right(); ++bucket_x) {
+				unit_grid->for_each_bucket_unit(QPoint(bucket_x, bucket_y), owner_mask, [&](CUnit *unit) {
+					if (!marker.mark(unit)) {
+						return;
+					}
+
+					const Vec2i unit_max_pos(std::min<short>(unit->tilePos.x + unit->Type->get_tile_width() - 1, rbPos.x), std::min<short>(unit->tilePos.y + unit->Type->get_tile_height() - 1, rbPos.y));
+					bool found = false;
+					Vec2i first_pos;
+
+					for (int y = std::max(unit->tilePos.y, ltPos.y); y <= unit_max_pos.y; ++y) {
+						const auto [min_x, max_x] = get_row_span(y);
+						const int first_x = std::max<int>(min_x, unit->tilePos.x);
+
+						if (first_x <= std::min<int>(max_x, unit_max_pos.x)) {
+							first_pos = Vec2i(first_x, y);
+							found = true;
+							break;
+						}
+					}
+
+					if (!found || !pred(unit)) {
+						return;
+					}
+
+					const CUnitCache &cache = CMap::Map.get_tile_unit_cache(first_pos, z);
+					const int cache_index = static_cast<int>(std::find(cache.begin(), cache.end(), unit) - cache.begin());
+					keyed_units.emplace_back(first_pos.x + first_pos.y * map_layer->get_width(), cache_index, unit);
+				});
 			}
+		}
+
+		std::sort(keyed_units.begin(), keyed_units.end());
+
+		for (const auto &[tile_index, cache_index, unit] : keyed_units) {
+			units.push_back(unit);
+		}
+
+		return;
+	}
+
+	for (Vec2i posIt = ltPos; posIt.y != rbPos.y + 1; ++posIt.y) {
+		const auto [min_x, max_x] = get_row_span(posIt.y);
 
+		for (posIt.x = min_x; posIt.x <= max_x; ++posIt.x) {
 			const CUnitCache &cache = CMap::Map.get_tile_unit_cache(posIt, z);
 
 			for (CUnit *unit : cache) {
-				if (unit->CacheLock == 0 && pred(unit)) {
-					unit->CacheLock = 1;
+				if ((owner_mask & (static_cast<uint64_t>(1) << unit->Player->Index)) == 0) {
+					continue;
+				}
+
+				if (marker.mark(unit) && pred(unit)) {
 					units.push_back(unit);
 				}
 			}
 		}
 	}
-	for (size_t i = 0; i != units.size(); ++i) {
-		units[i]->CacheLock = 0;
-	}
 }
 
 template <bool circle = false, typename Pred>
-inline void SelectAroundUnit(const CUnit &unit, const int range, std::vector<CUnit *> &around, Pred pred)
+inline void SelectAroundUnit(const CUnit &unit, const int range, std::vector<CUnit *> &around, const uint64_t owner_mask, Pred pred)
 {
 	const Vec2i offset(range, range);
 	const CUnit *firstContainer = unit.GetFirstContainer();
@@ -392,14 +471,18 @@ inline void SelectAroundUnit(const CUnit &unit, const int range, std::vector<CUn
 		   //Wyrmgus start
 		   unit.MapLayer->ID,
 		   //Wyrmgus end
+		   owner_mask,
 		   MakeAndPredicate(IsNotTheSameUnitAs(unit), pred));
 }
 
 template <bool circle = false, typename Pred>
-//Wyrmgus start
-//inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, Pred pred)
-inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, const int z, Pred pred)
-//Wyrmgus end
+inline void SelectAroundUnit(const CUnit &unit, const int range, std::vector<CUnit *> &around, Pred pred)
+{
+	SelectAroundUnit<circle>(unit, range, around, AllPlayersMask, pred);
+}
+
+template <bool circle = false, typename Pred>
+inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, const int z, const uint64_t owner_mask, Pred pred)
 {
 	Vec2i minPos = ltPos;
 	Vec2i maxPos = rbPos;
@@ -408,10 +491,19 @@ inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *>
 //	CMap::Map.FixSelectionArea(minPos, maxPos);
 //	SelectFixed(minPos, maxPos, units, pred);
 	CMap::Map.FixSelectionArea(minPos, maxPos, z);
-	SelectFixed<circle>(minPos, maxPos, units, z, pred);
+	SelectFixed<circle>(minPos, maxPos, units, z, owner_mask, pred);
 	//Wyrmgus end
 }
 
+template <bool circle = false, typename Pred>
+//Wyrmgus start
+//inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, Pred pred)
+inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, const int z, Pred pred)
+//Wyrmgus end
+{
+	Select<circle>(ltPos, rbPos, units, z, AllPlayersMask, pred);
+}
+
 template <bool circle = false>
 inline void Select(const Vec2i &ltPos, const Vec2i &rbPos, std::vector<CUnit *> &units, const int z)
 {
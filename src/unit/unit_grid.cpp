@@ -0,0 +1,149 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#include "stratagus.h"
+
+#include "unit/unit_grid.h"
+
+#include "unit/unit.h"
+#include "unit/unit_type.h"
+
+namespace wyrmgus {
+
+unit_grid::unit_grid(const QSize &map_size) : map_size(map_size)
+{
+	this->size = QSize((map_size.width() + unit_grid::bucket_size - 1) / unit_grid::bucket_size, (map_size.height() + unit_grid::bucket_size - 1) / unit_grid::bucket_size);
+	this->buckets.resize(this->size.width() * this->size.height());
+}
+
+void unit_grid::insert(CUnit *unit)
+{
+	const QRect bucket_rect = this->get_unit_bucket_rect(unit);
+
+	for (int y = bucket_rect.top(); y <= bucket_rect.bottom(); ++y) {
+		for (int x = bucket_rect.left(); x <= bucket_rect.right(); ++x) {
+			unit_grid::insert_into_bucket(this->buckets[x + y * this->size.width()], unit, unit->Player->Index);
+		}
+	}
+}
+
+void unit_grid::remove(CUnit *unit)
+{
+	const QRect bucket_rect = this->get_unit_bucket_rect(unit);
+
+	for (int y = bucket_rect.top(); y <= bucket_rect.bottom(); ++y) {
+		for (int x = bucket_rect.left(); x <= bucket_rect.right(); ++x) {
+			unit_grid_bucket &bucket = this->buckets[x + y * this->size.width()];
+
+			if (unit_grid::remove_from_bucket(bucket, unit, unit->Player->Index)) {
+				continue;
+			}
+
+			//the unit may have changed owner without the grid being told, so look for it in the other players' partitions
+			for (size_t i = 0; i < bucket.player_units.size(); ++i) {
+				if (unit_grid::remove_from_bucket(bucket, unit, bucket.player_units[i].first)) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+void unit_grid::on_unit_owner_changed(CUnit *unit, const int old_player_index)
+{
+	const QRect bucket_rect = this->get_unit_bucket_rect(unit);
+
+	for (int y = bucket_rect.top(); y <= bucket_rect.bottom(); ++y) {
+		for (int x = bucket_rect.left(); x <= bucket_rect.right(); ++x) {
+			unit_grid_bucket &bucket = this->buckets[x + y * this->size.width()];
+
+			if (unit_grid::remove_from_bucket(bucket, unit, old_player_index)) {
+				unit_grid::insert_into_bucket(bucket, unit, unit->Player->Index);
+			}
+		}
+	}
+}
+
+QRect unit_grid::get_unit_bucket_rect(const CUnit *unit) const
+{
+	//the unit's tiles are clipped to the map layer, as is done when placing the unit in the tiles' unit caches
+	const QPoint top_left = unit->tilePos;
+	const QPoint bottom_right(std::min(unit->tilePos.x + unit->Type->get_tile_width(), this->map_size.width()) - 1, std::min(unit->tilePos.y + unit->Type->get_tile_height(), this->map_size.height()) - 1);
+
+	return this->get_bucket_rect(QRect(top_left, bottom_right));
+}
+
+void unit_grid::insert_into_bucket(unit_grid_bucket &bucket, CUnit *unit, const int player_index)
+{
+	const uint64_t player_bit = static_cast<uint64_t>(1) << player_index;
+
+	if ((bucket.player_mask & player_bit) == 0) {
+		bucket.player_mask |= player_bit;
+		bucket.player_units.emplace_back(player_index, std::vector<CUnit *>());
+	}
+
+	for (auto &[partition_player_index, units] : bucket.player_units) {
+		if (partition_player_index == player_index) {
+			units.push_back(unit);
+			return;
+		}
+	}
+}
+
+bool unit_grid::remove_from_bucket(unit_grid_bucket &bucket, CUnit *unit, const int player_index)
+{
+	if ((bucket.player_mask & (static_cast<uint64_t>(1) << player_index)) == 0) {
+		return false;
+	}
+
+	for (auto partition_iterator = bucket.player_units.begin(); partition_iterator != bucket.player_units.end(); ++partition_iterator) {
+		if (partition_iterator->first != player_index) {
+			continue;
+		}
+
+		std::vector<CUnit *> &units = partition_iterator->second;
+
+		//the order of the units in a bucket doesn't matter, so the removed unit can be swapped with the last one
+		const auto find_iterator = std::find(units.begin(), units.end(), unit);
+		if (find_iterator == units.end()) {
+			return false;
+		}
+
+		*find_iterator = units.back();
+		units.pop_back();
+
+		if (units.empty()) {
+			bucket.player_units.erase(partition_iterator);
+			bucket.player_mask &= ~(static_cast<uint64_t>(1) << player_index);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+}
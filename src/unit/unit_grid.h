@@ -0,0 +1,95 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#pragma once
+
+class CUnit;
+
+namespace wyrmgus {
+
+//the units placed on the tiles of a bucket, partitioned by their owner
+struct unit_grid_bucket final
+{
+	uint64_t player_mask = 0; //the players which have units in the bucket, with each player being represented as one bit
+	std::vector<std::pair<int, std::vector<CUnit *>>> player_units; //the units in the bucket, per owning player
+};
+
+//a grid of square buckets of tiles over a map layer, each holding the units placed on its tiles, so that queries over large areas only go through the units of the buckets they overlap, instead of through the unit cache of every tile
+//the units of a bucket are partitioned by owner, so that queries for the units of some players only (e.g. enemies) skip those of the others
+class unit_grid final
+{
+public:
+	static constexpr int bucket_size = 8; //the width and height of a bucket, in tiles
+
+	//the minimum tile area of a query for it to be worth going through the buckets instead of the tiles
+	static constexpr int min_query_area = 256;
+
+	explicit unit_grid(const QSize &map_size);
+
+	void insert(CUnit *unit);
+	void remove(CUnit *unit);
+	void on_unit_owner_changed(CUnit *unit, const int old_player_index);
+
+	//get the rectangle of buckets which overlap a tile rectangle
+	QRect get_bucket_rect(const QRect &tile_rect) const
+	{
+		return QRect(QPoint(tile_rect.left() / unit_grid::bucket_size, tile_rect.top() / unit_grid::bucket_size), QPoint(tile_rect.right() / unit_grid::bucket_size, tile_rect.bottom() / unit_grid::bucket_size));
+	}
+
+	//call a function for each unit in a bucket owned by one of the players of a mask; units occupying several buckets are in each of them
+	template <typename function_type>
+	void for_each_bucket_unit(const QPoint &bucket_pos, const uint64_t player_mask, const function_type &function) const
+	{
+		const unit_grid_bucket &bucket = this->buckets[bucket_pos.x() + bucket_pos.y() * this->size.width()];
+
+		if ((bucket.player_mask & player_mask) == 0) {
+			return;
+		}
+
+		for (const auto &[player_index, units] : bucket.player_units) {
+			if ((player_mask & (static_cast<uint64_t>(1) << player_index)) == 0) {
+				continue;
+			}
+
+			for (CUnit *unit : units) {
+				function(unit);
+			}
+		}
+	}
+
+private:
+	QRect get_unit_bucket_rect(const CUnit *unit) const;
+
+	static void insert_into_bucket(unit_grid_bucket &bucket, CUnit *unit, const int player_index);
+	static bool remove_from_bucket(unit_grid_bucket &bucket, CUnit *unit, const int player_index);
+
+private:
+	QSize map_size; //the size of the map layer, in tiles
+	QSize size; //the size of the grid, in buckets
+	std::vector<unit_grid_bucket> buckets;
+};
+
+}
@@ -53,6 +53,7 @@ void unit_manager::init()
 {
 	this->lastCreated = nullptr;
 	this->units.clear();
+	this->pending_removed_units.clear();
 	this->released_units.clear();
 	this->unit_slots.clear();
 }
@@ -150,15 +151,12 @@ void unit_manager::ReleaseUnit(CUnit *unit)
 	}
 
 	if (unit->UnitManagerData.unitSlot != -1) { // == -1 when loading.
-		if (this->units[unit->UnitManagerData.unitSlot] != unit) {
-			throw std::runtime_error("Unit has index \"" + std::to_string(unit->UnitManagerData.unitSlot) + "\" in the unit manager's units vector, but another unit is present there at that index.");
+		if (this->iteration_depth > 0) {
+			//removing the unit now would move another unit to its index
+			this->pending_removed_units.push_back(unit);
+		} else {
+			this->remove_unit(unit);
 		}
-
-		CUnit *temp = this->units.back();
-		temp->UnitManagerData.unitSlot = unit->UnitManagerData.unitSlot;
-		this->units[unit->UnitManagerData.unitSlot] = temp;
-		unit->UnitManagerData.unitSlot = -1;
-		this->units.pop_back();
 	}
 
 	if (!unit->Destroyed) {
@@ -170,6 +168,28 @@ void unit_manager::ReleaseUnit(CUnit *unit)
 	//Refs = GameCycle + (NetworkMaxLag << 1); // could be reuse after this time
 }
 
+void unit_manager::remove_unit(CUnit *unit)
+{
+	if (this->units[unit->UnitManagerData.unitSlot] != unit) {
+		throw std::runtime_error("Unit has index \"" + std::to_string(unit->UnitManagerData.unitSlot) + "\" in the unit manager's units vector, but another unit is present there at that index.");
+	}
+
+	CUnit *temp = this->units.back();
+	temp->UnitManagerData.unitSlot = unit->UnitManagerData.unitSlot;
+	this->units[unit->UnitManagerData.unitSlot] = temp;
+	unit->UnitManagerData.unitSlot = -1;
+	this->units.pop_back();
+}
+
+void unit_manager::remove_pending_units()
+{
+	for (CUnit *unit : this->pending_removed_units) {
+		this->remove_unit(unit);
+	}
+
+	this->pending_removed_units.clear();
+}
+
 CUnit &unit_manager::GetSlotUnit(const int index) const
 {
 	return *this->unit_slots[index];
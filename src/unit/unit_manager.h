@@ -39,6 +39,31 @@ class unit_ref;
 class unit_manager final : public singleton<unit_manager>
 {
 public:
+	//while in scope, the units vector can be iterated in place by index: released units are only removed from it when the last guard goes out of scope, and added units are appended to it, after the indices that were iterated
+	class iteration_guard final
+	{
+	public:
+		explicit iteration_guard(unit_manager *manager) : manager(manager)
+		{
+			++this->manager->iteration_depth;
+		}
+
+		~iteration_guard()
+		{
+			--this->manager->iteration_depth;
+
+			if (this->manager->iteration_depth == 0) {
+				this->manager->remove_pending_units();
+			}
+		}
+
+		iteration_guard(const iteration_guard &other) = delete;
+		iteration_guard &operator =(const iteration_guard &other) = delete;
+
+	private:
+		unit_manager *manager = nullptr;
+	};
+
 	unit_manager();
 	~unit_manager();
 
@@ -69,6 +94,10 @@ public:
 	void add_unit_seen_under_fog(CUnit *unit);
 	void remove_unit_seen_under_fog(CUnit *unit);
 
+private:
+	void remove_unit(CUnit *unit);
+	void remove_pending_units();
+
 private:
 	//units currently in use
 	std::vector<CUnit *> units;
@@ -79,6 +108,9 @@ private:
 	std::list<CUnit *> released_units;
 	CUnit *lastCreated = nullptr;
 
+	int iteration_depth = 0; //the number of iteration guards in scope
+	std::vector<CUnit *> pending_removed_units; //units released while the units vector was being iterated, to be removed from it afterwards
+
 	//units seen under fog, which we need to keep references to in order to prevent them from being released
 	std::map<const CUnit *, std::shared_ptr<unit_ref>> units_seen_under_fog;
 };
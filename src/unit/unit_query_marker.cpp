@@ -0,0 +1,85 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#include "stratagus.h"
+
+#include "unit/unit_query_marker.h"
+
+#include "unit/unit.h"
+
+namespace wyrmgus {
+
+unit_query_marker::unit_query_marker()
+{
+	thread_state &state = unit_query_marker::get_thread_state();
+
+	if (state.depth == state.tables.size()) {
+		state.tables.push_back(std::make_unique<stamp_table>());
+	}
+
+	this->table = state.tables[state.depth].get();
+	++state.depth;
+
+	++this->table->generation;
+
+	if (this->table->generation == 0) {
+		//the generation has wrapped around, so clear the stamps, as they could otherwise be equal to the new generation
+		std::fill(this->table->stamps.begin(), this->table->stamps.end(), 0);
+		this->table->generation = 1;
+	}
+}
+
+unit_query_marker::~unit_query_marker()
+{
+	--unit_query_marker::get_thread_state().depth;
+}
+
+bool unit_query_marker::mark(const CUnit *unit)
+{
+	const size_t slot = static_cast<size_t>(unit->UnitManagerData.GetUnitId());
+
+	if (slot >= this->table->stamps.size()) {
+		this->table->stamps.resize(slot + 1, 0);
+	}
+
+	uint32_t &stamp = this->table->stamps[slot];
+
+	if (stamp == this->table->generation) {
+		return false;
+	}
+
+	stamp = this->table->generation;
+	return true;
+}
+
+unit_query_marker::thread_state &unit_query_marker::get_thread_state()
+{
+	thread_local thread_state state;
+	return state;
+}
+
+}
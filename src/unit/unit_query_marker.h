@@ -0,0 +1,69 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#pragma once
+
+class CUnit;
+
+namespace wyrmgus {
+
+//marks the units visited by a unit query, so that units occupying several tiles are only visited once by it
+//instead of setting a flag in the units and clearing it after the query, each query uses a new generation, with a unit having been visited if its stamp is equal to the query's generation
+//the stamps are indexed by unit slot, and are kept per thread and per query nesting depth, so that queries made from other threads, or from within the predicate of another query, don't interfere with each other
+class unit_query_marker final
+{
+private:
+	struct stamp_table final
+	{
+		std::vector<uint32_t> stamps;
+		uint32_t generation = 0;
+	};
+
+	struct thread_state final
+	{
+		std::vector<std::unique_ptr<stamp_table>> tables; //the stamp tables per nesting depth
+		size_t depth = 0;
+	};
+
+public:
+	unit_query_marker();
+	~unit_query_marker();
+
+	unit_query_marker(const unit_query_marker &other) = delete;
+	unit_query_marker &operator =(const unit_query_marker &other) = delete;
+
+	//mark a unit as visited by the query, returning false if it had already been visited
+	bool mark(const CUnit *unit);
+
+private:
+	static thread_state &get_thread_state();
+
+private:
+	stamp_table *table = nullptr;
+};
+
+}
@@ -1482,7 +1482,7 @@ static void ApplyUpgradeModifier(CPlayer &player, const wyrmgus::upgrade_modifie
 							if (j != MANA_INDEX || um->Modifier.Variables[j].Value < 0) {
 								unit->Variable[j].Value += um->Modifier.Variables[j].Value;
 							}
-							unit->Variable[j].Increase += um->Modifier.Variables[j].Increase;
+							unit->change_variable_increase(j, um->Modifier.Variables[j].Increase);
 						}
 
 						unit->Variable[j].Max += um->Modifier.Variables[j].Max;
@@ -1522,6 +1522,9 @@ static void ApplyUpgradeModifier(CPlayer &player, const wyrmgus::upgrade_modifie
 				if (unit.Player->Index != player.Index) {
 					continue;
 				}
+
+				//the upgrade may have changed the unit's stats, so that it may no longer be able to sleep
+				unit.wake_up();
 				
 				//add or remove starting abilities from the unit if the upgrade enabled/disabled them
 				for (const CUpgrade *ability_upgrade : unit.Type->StartingAbilities) {
@@ -1762,7 +1765,7 @@ static void RemoveUpgradeModifier(CPlayer &player, const wyrmgus::upgrade_modifi
 							if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
 								unit->Variable[j].Value -= um->Modifier.Variables[j].Value;
 							}
-							unit->Variable[j].Increase -= um->Modifier.Variables[j].Increase;
+							unit->change_variable_increase(j, -um->Modifier.Variables[j].Increase);
 						}
 
 						unit->Variable[j].Max -= um->Modifier.Variables[j].Max;
@@ -1804,6 +1807,9 @@ static void RemoveUpgradeModifier(CPlayer &player, const wyrmgus::upgrade_modifi
 				if (unit.Player->Index != player.Index) {
 					continue;
 				}
+
+				//the upgrade may have changed the unit's stats, so that it may no longer be able to sleep
+				unit.wake_up();
 				
 				//add or remove starting abilities from the unit if the upgrade enabled/disabled them
 				for (const CUpgrade *ability_upgrade : unit.Type->StartingAbilities) {
@@ -1850,6 +1856,8 @@ void ApplyIndividualUpgradeModifier(CUnit &unit, const wyrmgus::upgrade_modifier
 {
 	Assert(um);
 
+	unit.wake_up();
+
 	for (size_t i = 0; i < um->RemoveUpgrades.size(); ++i) {
 		if (unit.GetIndividualUpgrade(um->RemoveUpgrades[i])) {
 			IndividualUpgradeLost(unit, um->RemoveUpgrades[i], true);
@@ -1873,7 +1881,7 @@ void ApplyIndividualUpgradeModifier(CUnit &unit, const wyrmgus::upgrade_modifier
 			if (j != MANA_INDEX || um->Modifier.Variables[j].Value < 0) {
 				unit.Variable[j].Value += um->Modifier.Variables[j].Value;
 			}
-			unit.Variable[j].Increase += um->Modifier.Variables[j].Increase;
+			unit.change_variable_increase(j, um->Modifier.Variables[j].Increase);
 		}
 		unit.Variable[j].Max += um->Modifier.Variables[j].Max;
 		unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
@@ -1936,6 +1944,8 @@ void RemoveIndividualUpgradeModifier(CUnit &unit, const wyrmgus::upgrade_modifie
 {
 	Assert(um);
 
+	unit.wake_up();
+
 	if (um->Modifier.Variables[SUPPLY_INDEX].Value) {
 		if (unit.IsAlive()) {
 			unit.Player->Supply -= um->Modifier.Variables[SUPPLY_INDEX].Value;
@@ -1953,7 +1963,7 @@ void RemoveIndividualUpgradeModifier(CUnit &unit, const wyrmgus::upgrade_modifie
 			if (j != MANA_INDEX || um->Modifier.Variables[j].Value >= 0) {
 				unit.Variable[j].Value -= um->Modifier.Variables[j].Value;
 			}
-			unit.Variable[j].Increase -= um->Modifier.Variables[j].Increase;
+			unit.change_variable_increase(j, -um->Modifier.Variables[j].Increase);
 		}
 		unit.Variable[j].Max -= um->Modifier.Variables[j].Max;
 		unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
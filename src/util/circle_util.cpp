@@ -0,0 +1,65 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#include "stratagus.h"
+
+#include "util/circle_util.h"
+
+namespace wyrmgus::circle {
+
+static std::map<int, std::vector<int>> row_half_widths_by_squared_radius;
+static std::shared_mutex row_half_widths_mutex;
+
+const std::vector<int> &get_row_half_widths(const int squared_radius)
+{
+	{
+		std::shared_lock lock(row_half_widths_mutex);
+
+		const auto find_iterator = row_half_widths_by_squared_radius.find(squared_radius);
+		if (find_iterator != row_half_widths_by_squared_radius.end()) {
+			return find_iterator->second;
+		}
+	}
+
+	std::unique_lock lock(row_half_widths_mutex);
+
+	//references to the elements of a map stay valid when other elements are inserted
+	std::vector<int> &row_half_widths = row_half_widths_by_squared_radius[squared_radius];
+
+	if (row_half_widths.empty() && squared_radius >= 0) {
+		const int radius = isqrt(squared_radius);
+		row_half_widths.reserve(radius + 1);
+
+		for (int dy = 0; dy <= radius; ++dy) {
+			row_half_widths.push_back(isqrt(squared_radius - dy * dy));
+		}
+	}
+
+	return row_half_widths;
+}
+
+}
@@ -0,0 +1,56 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#pragma once
+
+#include "util/util.h"
+
+namespace wyrmgus::circle {
+
+//get the half-widths of the rows of a circle, i.e. for each absolute vertical offset from its center, the greatest absolute horizontal offset for which dx * dx + dy * dy <= squared_radius
+//the half-widths are calculated once per squared radius and then cached, so that going through the tiles of a circle only needs a lookup per row, instead of a square root or a distance check per tile
+extern const std::vector<int> &get_row_half_widths(const int squared_radius);
+
+//get the half-width of a row of a circle from its half-widths, or 0 if the row is beyond the circle
+inline int get_row_half_width(const std::vector<int> &row_half_widths, const int dy)
+{
+	const size_t row = static_cast<size_t>(std::abs(dy));
+
+	if (row >= row_half_widths.size()) {
+		return 0;
+	}
+
+	return row_half_widths[row];
+}
+
+//get the squared radius of the circle of tiles within a range of a center tile, i.e. of the tiles for which dx * dx + dy * dy < (range + 1) * (range + 1), as used for sight
+inline int get_range_squared_radius(const int range)
+{
+	return square(range + 1) - 1;
+}
+
+}
@@ -47,7 +47,10 @@ thread_pool::~thread_pool()
 
 void thread_pool::post(const std::function<void()> &function)
 {
-	boost::asio::post(*this->pool, function);
+	boost::asio::post(*this->pool, [function]() {
+		thread_pool::current_thread_in_pool = true;
+		function();
+	});
 }
 
 }
@@ -38,6 +38,12 @@ namespace wyrmgus {
 class thread_pool final : public singleton<thread_pool>
 {
 public:
+	//get whether the current thread is one of the pool's
+	static bool is_pool_thread()
+	{
+		return thread_pool::current_thread_in_pool;
+	}
+
 	thread_pool();
 	~thread_pool();
 
@@ -57,6 +63,8 @@ public:
 	}
 
 private:
+	static inline thread_local bool current_thread_in_pool = false;
+
 	std::unique_ptr<boost::asio::thread_pool> pool;
 };
 
@@ -0,0 +1,216 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#pragma once
+
+namespace wyrmgus {
+
+//a hierarchical timer wheel of values keyed by the absolute game cycle at which they are due
+//each level has a slot per block of cycles of the level below it; values are placed in the lowest level whose block contains both the current cycle and their due cycle, and are moved down a level when the current cycle enters their block, so that each value is only touched a few times until it becomes due, rather than every cycle
+template <typename T>
+class timer_wheel final
+{
+public:
+	static constexpr uint64_t level_bits = 6;
+	static constexpr uint64_t slot_count = 1 << timer_wheel::level_bits;
+	static constexpr uint64_t slot_mask = timer_wheel::slot_count - 1;
+	static constexpr size_t level_count = 4;
+
+	uint64_t get_current_cycle() const
+	{
+		return this->current_cycle;
+	}
+
+	bool empty() const
+	{
+		return this->value_count == 0;
+	}
+
+	//get whether the wheel is processing the values due in its current cycle
+	bool is_advancing() const
+	{
+		return this->advancing;
+	}
+
+	size_t size() const
+	{
+		return this->value_count;
+	}
+
+	//add a value to become due at the given cycle; values due at or before the current cycle become due in the next one, unless they are added while the current cycle's values are being processed, in which case they are processed after them
+	void insert(const uint64_t cycle, T &&value)
+	{
+		wheel_entry entry;
+		entry.cycle = std::max(cycle, this->advancing ? this->current_cycle : this->current_cycle + 1);
+		entry.sequence = this->next_sequence++;
+		entry.value = std::move(value);
+
+		this->place(std::move(entry));
+		++this->value_count;
+	}
+
+	//advance the wheel to the given cycle, calling the function for each value which becomes due; values due in the same cycle are processed in the order in which they were inserted
+	template <typename function_type>
+	void advance(const uint64_t cycle, const function_type &function)
+	{
+		while (this->current_cycle < cycle) {
+			if (this->empty()) {
+				this->current_cycle = cycle;
+				return;
+			}
+
+			++this->current_cycle;
+			this->cascade();
+
+			std::vector<wheel_entry> &slot = this->levels[0][this->current_cycle & timer_wheel::slot_mask];
+
+			//the function may insert new values, and those due in the current cycle are processed in it as well
+			this->advancing = true;
+
+			while (!slot.empty()) {
+				std::vector<wheel_entry> due_entries = std::move(slot);
+				slot.clear();
+
+				this->value_count -= due_entries.size();
+
+				std::sort(due_entries.begin(), due_entries.end(), [](const wheel_entry &lhs, const wheel_entry &rhs) {
+					return lhs.sequence < rhs.sequence;
+				});
+
+				for (wheel_entry &entry : due_entries) {
+					function(entry.value);
+				}
+			}
+
+			this->advancing = false;
+		}
+	}
+
+	//call the function for each value with the cycle at which it is due, in the order in which the values were inserted
+	template <typename function_type>
+	void for_each(const function_type &function) const
+	{
+		std::vector<const wheel_entry *> entries;
+		entries.reserve(this->value_count);
+
+		for (const std::array<std::vector<wheel_entry>, timer_wheel::slot_count> &level : this->levels) {
+			for (const std::vector<wheel_entry> &slot : level) {
+				for (const wheel_entry &entry : slot) {
+					entries.push_back(&entry);
+				}
+			}
+		}
+
+		for (const wheel_entry &entry : this->overflow_entries) {
+			entries.push_back(&entry);
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const wheel_entry *lhs, const wheel_entry *rhs) {
+			return lhs->sequence < rhs->sequence;
+		});
+
+		for (const wheel_entry *entry : entries) {
+			function(entry->cycle, entry->value);
+		}
+	}
+
+	void clear()
+	{
+		for (std::array<std::vector<wheel_entry>, timer_wheel::slot_count> &level : this->levels) {
+			for (std::vector<wheel_entry> &slot : level) {
+				slot.clear();
+			}
+		}
+
+		this->overflow_entries.clear();
+		this->current_cycle = 0;
+		this->advancing = false;
+		this->next_sequence = 0;
+		this->value_count = 0;
+	}
+
+private:
+	struct wheel_entry final
+	{
+		uint64_t cycle = 0;
+		uint64_t sequence = 0; //the insertion order, to keep the processing of values due in the same cycle deterministic
+		T value;
+	};
+
+	void place(wheel_entry &&entry)
+	{
+		for (size_t level = 0; level < timer_wheel::level_count; ++level) {
+			const uint64_t block_shift = (level + 1) * timer_wheel::level_bits;
+
+			if ((entry.cycle >> block_shift) == (this->current_cycle >> block_shift)) {
+				const uint64_t slot = (entry.cycle >> (level * timer_wheel::level_bits)) & timer_wheel::slot_mask;
+				this->levels[level][slot].push_back(std::move(entry));
+				return;
+			}
+		}
+
+		//too far in the future for the highest level
+		this->overflow_entries.push_back(std::move(entry));
+	}
+
+	//move the values of the blocks which the current cycle has just entered down to the lower levels, starting from the highest level, so that values can move down several levels at once
+	void cascade()
+	{
+		if ((this->current_cycle & ((uint64_t(1) << (timer_wheel::level_count * timer_wheel::level_bits)) - 1)) == 0) {
+			this->replace_entries(this->overflow_entries);
+		}
+
+		for (size_t level = timer_wheel::level_count - 1; level > 0; --level) {
+			const uint64_t level_shift = level * timer_wheel::level_bits;
+
+			if ((this->current_cycle & ((uint64_t(1) << level_shift) - 1)) != 0) {
+				continue;
+			}
+
+			this->replace_entries(this->levels[level][(this->current_cycle >> level_shift) & timer_wheel::slot_mask]);
+		}
+	}
+
+	void replace_entries(std::vector<wheel_entry> &entries)
+	{
+		std::vector<wheel_entry> moved_entries = std::move(entries);
+		entries.clear();
+
+		for (wheel_entry &entry : moved_entries) {
+			this->place(std::move(entry));
+		}
+	}
+
+private:
+	std::array<std::array<std::vector<wheel_entry>, timer_wheel::slot_count>, timer_wheel::level_count> levels;
+	std::vector<wheel_entry> overflow_entries; //values beyond the range of the highest level, placed again whenever the current cycle enters a new block of it
+	uint64_t current_cycle = 0;
+	bool advancing = false;
+	uint64_t next_sequence = 0;
+	size_t value_count = 0;
+};
+
+}
@@ -421,6 +421,23 @@ static void InitKey2Str()
 	Key2Str[SDLK_UNDO] = "undo";
 }
 
+/**
+**  Initialize SDL for headless runs, which have no display or sound, but still use the SDL timer.
+*/
+void InitHeadlessSdl()
+{
+	if (SDL_WasInit(SDL_INIT_TIMER) != 0) {
+		return;
+	}
+
+	if (SDL_Init(SDL_INIT_TIMER) < 0) {
+		throw std::runtime_error("Couldn't initialize SDL: " + std::string(SDL_GetError()));
+	}
+
+	// Clean up on exit
+	atexit(SDL_Quit);
+}
+
 /**
 **  Initialize the video part for SDL.
 */
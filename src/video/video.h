@@ -487,6 +487,8 @@ extern void VideoCclRegister();
 
 /// initialize the video part
 extern void InitVideo();
+/// initialize only the SDL timer, for runs without display or sound
+extern void InitHeadlessSdl();
 
 /// deinitialize the video part
 void DeInitVideo();
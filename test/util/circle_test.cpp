@@ -0,0 +1,62 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#include "stratagus.h"
+
+#include "util/circle_util.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(circle_row_half_widths_test)
+{
+    for (int squared_radius = 0; squared_radius <= 400; ++squared_radius) {
+        const std::vector<int> &row_half_widths = circle::get_row_half_widths(squared_radius);
+
+        for (int dy = -25; dy <= 25; ++dy) {
+            int expected_half_width = 0;
+            for (int dx = 0; dx * dx + dy * dy <= squared_radius; ++dx) {
+                expected_half_width = dx;
+            }
+
+            BOOST_CHECK(circle::get_row_half_width(row_half_widths, dy) == expected_half_width);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(circle_range_squared_radius_test)
+{
+    //the same half-widths as the sight code used to calculate for each row
+    for (int range = 0; range <= 20; ++range) {
+        const std::vector<int> &row_half_widths = circle::get_row_half_widths(circle::get_range_squared_radius(range));
+
+        for (int dy = 1; dy <= range; ++dy) {
+            BOOST_CHECK(circle::get_row_half_width(row_half_widths, dy) == isqrt(square(range + 1) - square(dy) - 1));
+        }
+    }
+
+    BOOST_CHECK(circle::get_row_half_widths(circle::get_range_squared_radius(-1)).empty());
+}
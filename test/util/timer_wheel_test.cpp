@@ -0,0 +1,101 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+//      (c) Copyright 2021 by Andrettin
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#include "stratagus.h"
+
+#include "util/timer_wheel.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(timer_wheel_order_test)
+{
+    timer_wheel<int> wheel;
+
+    wheel.insert(100, 1);
+    wheel.insert(5, 2);
+    wheel.insert(100, 3);
+    wheel.insert(70000, 4);
+    wheel.insert(20000000, 5);
+
+    BOOST_CHECK(wheel.size() == 5);
+
+    std::vector<int> due_values;
+    const auto function = [&due_values](const int value) {
+        due_values.push_back(value);
+    };
+
+    wheel.advance(99, function);
+    BOOST_CHECK(due_values == std::vector<int>({ 2 }));
+
+    wheel.advance(100, function);
+    BOOST_CHECK(due_values == std::vector<int>({ 2, 1, 3 }));
+
+    wheel.advance(69999, function);
+    BOOST_CHECK(due_values.size() == 3);
+
+    wheel.advance(20000000, function);
+    BOOST_CHECK(due_values == std::vector<int>({ 2, 1, 3, 4, 5 }));
+    BOOST_CHECK(wheel.empty());
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel_overdue_test)
+{
+    timer_wheel<int> wheel;
+
+    wheel.advance(1000, [](const int) {});
+    BOOST_CHECK(wheel.get_current_cycle() == 1000);
+
+    //a value due in the past becomes due in the next cycle
+    wheel.insert(10, 1);
+
+    int due_value = 0;
+    wheel.advance(1001, [&due_value](const int value) {
+        due_value = value;
+    });
+
+    BOOST_CHECK(due_value == 1);
+}
+
+BOOST_AUTO_TEST_CASE(timer_wheel_insert_while_advancing_test)
+{
+    timer_wheel<int> wheel;
+
+    wheel.insert(1, 1);
+
+    std::vector<int> due_values;
+    wheel.advance(1, [&wheel, &due_values](const int value) {
+        due_values.push_back(value);
+
+        //a value inserted for the cycle being processed is processed in it, after the values already due
+        if (value == 1) {
+            wheel.insert(1, 2);
+            wheel.insert(2, 3);
+        }
+    });
+
+    BOOST_CHECK(due_values == std::vector<int>({ 1, 2 }));
+    BOOST_CHECK(wheel.size() == 1);
+}